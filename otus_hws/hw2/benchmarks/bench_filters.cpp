@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ip_filter.hpp"
+#include "prefix_index.hpp"
+#include "radix_sort.hpp"
+#include "simd_filter.hpp"
+#include "synthetic.hpp"
+
+static const std::vector<uint32_t>& sorted_keys(size_t size) {
+    static std::map<size_t, std::vector<uint32_t>> cache;
+    auto it = cache.find(size);
+    if (it == cache.end()) {
+        auto keys = synthetic_keys(size);
+        radix_sort_desc(keys);
+        it = cache.emplace(size, std::move(keys)).first;
+    }
+    return it->second;
+}
+
+static std::vector<Ip> sorted_ips(size_t size) {
+    std::vector<Ip> ips;
+    for (uint32_t key : sorted_keys(size)) {
+        ips.emplace_back(key);
+    }
+    return ips;
+}
+
+// Original per-Ip loops of main.cpp, kept as baseline
+
+template <typename Pred>
+static void run_ip_loop(benchmark::State& state, Pred pred) {
+    const auto ips = sorted_ips(lines_of(state));
+    std::vector<Ip> out;
+    out.reserve(ips.size());
+    for (auto _ : state) {
+        out.clear();
+        std::for_each(ips.cbegin(), ips.cend(), [&out, &pred](const Ip& ip) {
+            if (pred(ip)) {
+                out.push_back(ip);
+            }
+        });
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_FirstIs1Loop(benchmark::State& state) {
+    run_ip_loop(state, [](const Ip& ip) { return ip.octet(0) == 1; });
+}
+
+static void BM_First46Second70Loop(benchmark::State& state) {
+    run_ip_loop(state, [](const Ip& ip) { return ip.octet(0) == 46 && ip.octet(1) == 70; });
+}
+
+static void BM_AnyIs46Loop(benchmark::State& state) {
+    run_ip_loop(state, [](const Ip& ip) {
+        auto octets = ip.octets();
+        return std::any_of(octets.cbegin(), octets.cend(), [](const int& ip_part) { return ip_part == 46; });
+    });
+}
+
+// Kernels of every supported simd level
+
+static void BM_AnyByteKernel(benchmark::State& state, SimdLevel level) {
+    const auto& keys = sorted_keys(lines_of(state));
+    std::vector<uint32_t> out(keys.size());
+    const auto& kernels = filter_kernels(level);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels.any_byte_eq(keys.data(), keys.size(), 46, out.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_PrefixKernel(benchmark::State& state, SimdLevel level) {
+    const auto& keys = sorted_keys(lines_of(state));
+    std::vector<uint32_t> out(keys.size());
+    const auto& kernels = filter_kernels(level);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels.prefix_eq(keys.data(), keys.size(), 0x2E460000, 0xFFFF0000, out.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void register_kernels() {
+    for (auto level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        if (level > detect_simd_level()) {
+            continue;
+        }
+        const std::string name = filter_kernels(level).name;
+        benchmark::RegisterBenchmark(("BM_AnyByteKernel/" + name).c_str(), BM_AnyByteKernel, level)->Apply(bench_sizes);
+        benchmark::RegisterBenchmark(("BM_PrefixKernel/" + name).c_str(), BM_PrefixKernel, level)->Apply(bench_sizes);
+    }
+}
+
+static const int kernels_registered = (register_kernels(), 0);
+
+// Prefix index: build once per pool, then lookups
+
+static void BM_PrefixIndexBuild(benchmark::State& state) {
+    const auto& keys = sorted_keys(lines_of(state));
+    for (auto _ : state) {
+        PrefixIndex index(keys);
+        benchmark::DoNotOptimize(index.table().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_PrefixIndexQuery(benchmark::State& state) {
+    const auto& keys = sorted_keys(lines_of(state));
+    PrefixIndex index(keys);
+    const Cidr cidr = parse_cidr("46.70.0.0/20");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.prefix(1).size());
+        benchmark::DoNotOptimize(index.prefix(46, 70).size());
+        benchmark::DoNotOptimize(index.cidr(cidr).size());
+    }
+}
+
+BENCHMARK(BM_FirstIs1Loop)->Apply(bench_sizes);
+BENCHMARK(BM_First46Second70Loop)->Apply(bench_sizes);
+BENCHMARK(BM_AnyIs46Loop)->Apply(bench_sizes);
+BENCHMARK(BM_PrefixIndexBuild)->Apply(bench_sizes);
+BENCHMARK(BM_PrefixIndexQuery)->Apply(bench_sizes)->Unit(benchmark::kNanosecond);
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <vector>
+
+#include "ip_filter.hpp"
+#include "ip_writer.hpp"
+#include "synthetic.hpp"
+
+// Both sinks write to /dev/null, so only formatting and buffering are measured
+
+static void BM_IpStrToStream(benchmark::State& state) {
+    const auto& keys = synthetic_keys(lines_of(state));
+    std::ofstream out("/dev/null");
+    for (auto _ : state) {
+        for (uint32_t key : keys) {
+            out << Ip(key).str() << '\n';
+        }
+        out.flush();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IpWriter(benchmark::State& state) {
+    const auto& keys = synthetic_keys(lines_of(state));
+    int fd = ::open("/dev/null", O_WRONLY);
+    for (auto _ : state) {
+        IpWriter out(fd);
+        out.write_ips(keys);
+        out.flush();
+    }
+    ::close(fd);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_IpStrToStream)->Apply(bench_sizes);
+BENCHMARK(BM_IpWriter)->Apply(bench_sizes);
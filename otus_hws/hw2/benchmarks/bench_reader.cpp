@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+
+#include "ip_filter.hpp"
+#include "ip_reader.hpp"
+#include "synthetic.hpp"
+
+static void BM_Split(benchmark::State& state) {
+    std::istringstream input(synthetic_log(lines_of(state)));
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(input, line);) {
+        lines.push_back(std::move(line));
+    }
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            benchmark::DoNotOptimize(split(line, '\t'));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IpFromString(benchmark::State& state) {
+    std::vector<std::string> texts;
+    for (uint32_t key : synthetic_keys(lines_of(state))) {
+        texts.push_back(Ip(key).str());
+    }
+    for (auto _ : state) {
+        for (const auto& text : texts) {
+            benchmark::DoNotOptimize(Ip(text));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ParseIp(benchmark::State& state) {
+    std::vector<std::string> texts;
+    for (uint32_t key : synthetic_keys(lines_of(state))) {
+        texts.push_back(Ip(key).str());
+    }
+    for (auto _ : state) {
+        for (const auto& text : texts) {
+            uint32_t collapsed_ip = 0;
+            benchmark::DoNotOptimize(parse_ip(text.data(), text.data() + text.size(), collapsed_ip));
+            benchmark::DoNotOptimize(collapsed_ip);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// getline + split + stoi
+static void BM_ReadFromFile(benchmark::State& state) {
+    const auto& file = synthetic_log_file(lines_of(state));
+    for (auto _ : state) {
+        auto ip_pool = read_from_file(file.path());
+        benchmark::DoNotOptimize(ip_pool.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_MapFromFile(benchmark::State& state) {
+    const auto& file = synthetic_log_file(lines_of(state));
+    for (auto _ : state) {
+        auto ip_pool = map_from_file(file.path());
+        benchmark::DoNotOptimize(ip_pool.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ReadFromStream(benchmark::State& state) {
+    const auto& log = synthetic_log(lines_of(state));
+    for (auto _ : state) {
+        std::istringstream input(log);
+        auto ip_pool = read_from_stream(input);
+        benchmark::DoNotOptimize(ip_pool.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Split)->Apply(bench_sizes);
+BENCHMARK(BM_IpFromString)->Apply(bench_sizes);
+BENCHMARK(BM_ParseIp)->Apply(bench_sizes);
+BENCHMARK(BM_ReadFromFile)->Apply(bench_sizes);
+BENCHMARK(BM_MapFromFile)->Apply(bench_sizes);
+BENCHMARK(BM_ReadFromStream)->Apply(bench_sizes);
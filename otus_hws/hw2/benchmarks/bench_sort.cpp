@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "ip_filter.hpp"
+#include "parallel_pipeline.hpp"
+#include "radix_sort.hpp"
+#include "synthetic.hpp"
+
+static void BM_StdSort(benchmark::State& state) {
+    const auto& keys = synthetic_keys(lines_of(state));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto sorted = keys;
+        state.ResumeTiming();
+        std::sort(sorted.begin(), sorted.end(), std::greater<uint32_t>());
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_RadixSort(benchmark::State& state) {
+    const auto& keys = synthetic_keys(lines_of(state));
+    std::vector<uint32_t> buffer(keys.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto sorted = keys;
+        state.ResumeTiming();
+        radix_sort_desc(sorted.data(), buffer.data(), sorted.size());
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_LexicographicallySort(benchmark::State& state) {
+    const auto& keys = synthetic_keys(lines_of(state));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto sorted = keys;
+        state.ResumeTiming();
+        lexicographically_sort(sorted);
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// whole -j pipeline over in-memory log: parse, sort runs, merge and filter
+static void BM_ParallelPipeline(benchmark::State& state) {
+    const auto& log = synthetic_log(lines_of(state));
+    const auto threads = static_cast<size_t>(state.range(1));
+    for (auto _ : state) {
+        auto result = run_parallel_pipeline(log.data(), log.data() + log.size(), threads);
+        benchmark::DoNotOptimize(result.sorted.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_StdSort)->Apply(bench_sizes);
+BENCHMARK(BM_RadixSort)->Apply(bench_sizes);
+BENCHMARK(BM_LexicographicallySort)->Apply(bench_sizes);
+BENCHMARK(BM_ParallelPipeline)->Apply([](benchmark::internal::Benchmark* bench) {
+    for (int64_t lines : bench_line_counts()) {
+        for (int64_t threads : {1, 2, 4, 8}) {
+            bench->Args({lines, threads});
+        }
+    }
+    bench->Unit(benchmark::kMillisecond)->UseRealTime();
+});
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Dataset sizes 1K..100M lines, capped by IP_FILTER_BENCH_MAX_LINES (default 1M)
+inline std::vector<int64_t> bench_line_counts() {
+    size_t max_lines = 1'000'000;
+    if (const char* env = std::getenv("IP_FILTER_BENCH_MAX_LINES")) {
+        max_lines = std::strtoull(env, nullptr, 10);
+    }
+    std::vector<int64_t> counts;
+    for (size_t lines = 1'000; lines <= 100'000'000 && lines <= max_lines; lines *= 10) {
+        counts.push_back(static_cast<int64_t>(lines));
+    }
+    return counts;
+}
+
+inline void bench_sizes(benchmark::internal::Benchmark* bench) {
+    for (int64_t lines : bench_line_counts()) {
+        bench->Arg(lines);
+    }
+    bench->Unit(benchmark::kMillisecond);
+}
+
+inline size_t lines_of(const benchmark::State& state) {
+    return static_cast<size_t>(state.range(0));
+}
+
+// Same seed - same data on every run, so results are comparable between commits
+inline std::vector<uint32_t> make_keys(size_t size, uint32_t seed = 42) {
+    std::mt19937 gen(seed);
+    std::vector<uint32_t> keys(size);
+    for (auto& key : keys) {
+        key = gen();
+    }
+    return keys;
+}
+
+// ip_filter-like log: "a.b.c.d\t<n>\t<n>\n" per line
+inline std::string make_ip_log(size_t lines, uint32_t seed = 42) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> octet(0, 255);
+    std::uniform_int_distribution<uint32_t> counter(0, 1000);
+
+    std::string log;
+    log.reserve(lines * 24);
+    for (size_t i = 0; i < lines; i++) {
+        log += std::to_string(octet(gen));
+        log += '.';
+        log += std::to_string(octet(gen));
+        log += '.';
+        log += std::to_string(octet(gen));
+        log += '.';
+        log += std::to_string(octet(gen));
+        log += '\t';
+        log += std::to_string(counter(gen));
+        log += '\t';
+        log += std::to_string(counter(gen));
+        log += '\n';
+    }
+    return log;
+}
+
+// Log dumped to temp dir, removed on destruction
+class SyntheticLogFile {
+public:
+    explicit SyntheticLogFile(size_t lines)
+        : path_(std::filesystem::temp_directory_path() / ("ip_filter_bench_" + std::to_string(lines) + ".tsv")) {
+        std::ofstream(path_, std::ios::binary) << make_ip_log(lines);
+    }
+
+    ~SyntheticLogFile() {
+        std::filesystem::remove(path_);
+    }
+
+    std::string path() const {
+        return path_.string();
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Datasets are generated once per size and shared by all benchmarks of the binary
+inline const std::vector<uint32_t>& synthetic_keys(size_t size) {
+    static std::map<size_t, std::vector<uint32_t>> cache;
+    auto it = cache.find(size);
+    if (it == cache.end()) {
+        it = cache.emplace(size, make_keys(size)).first;
+    }
+    return it->second;
+}
+
+inline const std::string& synthetic_log(size_t lines) {
+    static std::map<size_t, std::string> cache;
+    auto it = cache.find(lines);
+    if (it == cache.end()) {
+        it = cache.emplace(lines, make_ip_log(lines)).first;
+    }
+    return it->second;
+}
+
+inline const SyntheticLogFile& synthetic_log_file(size_t lines) {
+    static std::map<size_t, std::unique_ptr<SyntheticLogFile>> cache;
+    auto& file = cache[lines];
+    if (!file) {
+        file = std::make_unique<SyntheticLogFile>(lines);
+    }
+    return *file;
+}
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 #if __cplusplus >= 202302L
 #include <format>
@@ -14,18 +16,26 @@
 
 struct Ip;
 std::vector<std::string> split(const std::string& str, char d);
-void lexicographically_sort(std::vector<Ip>& ip_pool);
+// collapsed ips in descending order, in place
+void lexicographically_sort(std::vector<uint32_t>& keys);
 std::vector<Ip> read_from_file(const std::string& file_path);
 std::vector<Ip> read_from_cmd();
 std::ostream& operator<<(std::ostream& os, const Ip& ip);
 
+// Only collapsed form is stored (first octet in the high byte), octets are derived on demand
 struct Ip {
-    std::array<uint8_t, 4> ip_;
     uint32_t collapsed_ip_;
 
     Ip(const std::string& ip);
-    Ip(const Ip& ip);
-    Ip& operator=(const Ip& ip);
+    explicit Ip(uint32_t collapsed_ip) noexcept;
+
+    uint8_t octet(size_t i) const noexcept {
+        return static_cast<uint8_t>(collapsed_ip_ >> (24 - 8 * i));
+    }
+    std::array<uint8_t, 4> octets() const noexcept {
+        return {octet(0), octet(1), octet(2), octet(3)};
+    }
+
     std::string str() const noexcept;
     bool operator>(const Ip& ip) const noexcept;
     bool operator<(const Ip& ip) const noexcept;
@@ -33,6 +43,9 @@ struct Ip {
     bool operator!=(const Ip& ip) const noexcept;
 };
 
+static_assert(sizeof(Ip) == sizeof(uint32_t));
+static_assert(std::is_trivially_copyable_v<Ip>);
+
 #if __cplusplus >= 202302L
 template <>
 struct std::formatter<Ip> : std::formatter<std::string> {
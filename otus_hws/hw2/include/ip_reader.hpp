@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ip_filter.hpp"
+
+// Parses dotted quad starting at `cur` straight into collapsed form (first octet in the high byte).
+// Returns pointer past the last consumed char or nullptr if there is no valid address.
+inline const char* parse_ip(const char* cur, const char* end, uint32_t& collapsed_ip) noexcept {
+    uint32_t result = 0;
+    for (int octet = 0; octet < 4; octet++) {
+        if (octet != 0) {
+            if (cur == end || *cur != '.') {
+                return nullptr;
+            }
+            ++cur;
+        }
+        uint32_t value = 0;
+        int digits = 0;
+        while (cur != end && digits < 3 && static_cast<unsigned char>(*cur - '0') < 10) {
+            value = value * 10 + static_cast<uint32_t>(*cur - '0');
+            ++cur;
+            ++digits;
+        }
+        if (digits == 0 || value > 255) {
+            return nullptr;
+        }
+        result = (result << 8) | value;
+    }
+    collapsed_ip = result;
+    return cur;
+}
+
+// Parses first tab-separated column of [line, eol). Empty lines are skipped.
+template <typename F>
+void parse_ip_line(const char* line, const char* eol, F& on_ip) {
+    if (eol != line && eol[-1] == '\r') {
+        --eol;
+    }
+    if (line == eol) {
+        return;
+    }
+    uint32_t collapsed_ip = 0;
+    const char* stop = parse_ip(line, eol, collapsed_ip);
+    if (!stop || (stop != eol && *stop != '\t')) {
+        const char* tab = static_cast<const char*>(std::memchr(line, '\t', static_cast<size_t>(eol - line)));
+        throw std::runtime_error("Bad string format: " + std::string(line, tab ? tab : eol));
+    }
+    on_ip(collapsed_ip);
+}
+
+// Calls on_ip(uint32_t) for every complete line of the buffer.
+// Returns the beginning of the unterminated tail (== end if buffer ends with '\n').
+template <typename F>
+const char* for_each_ip(const char* begin, const char* end, F&& on_ip) {
+    const char* line = begin;
+    while (line != end) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+        if (!eol) {
+            return line;
+        }
+        parse_ip_line(line, eol, on_ip);
+        line = eol + 1;
+    }
+    return end;
+}
+
+// Same as for_each_ip, but the unterminated tail is treated as the last line.
+template <typename F>
+void for_each_ip_final(const char* begin, const char* end, F&& on_ip) {
+    const char* tail = for_each_ip(begin, end, on_ip);
+    parse_ip_line(tail, end, on_ip);
+}
+
+constexpr size_t READ_CHUNK_SIZE = 1 << 20;
+
+// Chunked variant of for_each_ip_final for pipes: one buffer for the whole stream
+template <typename F>
+void for_each_ip_in_stream(std::istream& input, F&& on_ip, size_t chunk_size = READ_CHUNK_SIZE) {
+    std::vector<char> buffer(chunk_size);
+    size_t carry = 0;  // bytes of unterminated line left from previous chunk
+
+    for (;;) {
+        if (carry == buffer.size()) {
+            // line longer than the whole chunk
+            buffer.resize(buffer.size() * 2);
+        }
+        input.read(buffer.data() + carry, static_cast<std::streamsize>(buffer.size() - carry));
+        size_t bytes_read = static_cast<size_t>(input.gcount());
+        if (bytes_read == 0) {
+            break;
+        }
+        char* filled_end = buffer.data() + carry + bytes_read;
+        const char* tail = for_each_ip(buffer.data(), filled_end, on_ip);
+        carry = static_cast<size_t>(filled_end - tail);
+        std::memmove(buffer.data(), tail, carry);
+    }
+
+    for_each_ip_final(buffer.data(), buffer.data() + carry, on_ip);
+}
+
+// Read-only private mapping of the whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& file_path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const noexcept {
+        return data_;
+    }
+
+    const char* end() const noexcept {
+        return data_ + size_;
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// mmap file and parse it in place without per-line allocations, collapsed ips in file order
+std::vector<uint32_t> map_from_file(const std::string& file_path);
+// Chunked reader for pipes (stdin): same parser, one buffer for the whole stream
+std::vector<uint32_t> read_from_stream(std::istream& input, size_t chunk_size = READ_CHUNK_SIZE);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// One bit per IPv4 address (512 MiB of address space). Memory is an anonymous
+// mapping, so only pages of actually seen addresses are ever touched.
+class IpBitset {
+public:
+    static constexpr size_t BYTES = (size_t{1} << 32) / 8;
+
+    IpBitset();
+    ~IpBitset();
+
+    IpBitset(const IpBitset&) = delete;
+    IpBitset& operator=(const IpBitset&) = delete;
+
+    // true if key was not seen before
+    bool insert(uint32_t key) noexcept {
+        uint64_t& word = words_[key >> 6];
+        const uint64_t bit = uint64_t{1} << (key & 63);
+        const bool is_new = (word & bit) == 0;
+        word |= bit;
+        count_ += is_new;
+        return is_new;
+    }
+
+    bool contains(uint32_t key) const noexcept {
+        return (words_[key >> 6] >> (key & 63)) & 1;
+    }
+
+    size_t count() const noexcept {
+        return count_;
+    }
+
+private:
+    uint64_t* words_ = nullptr;
+    size_t count_ = 0;
+};
+
+struct HeavyHitter {
+    uint32_t key;
+    uint64_t count;  // upper bound of real frequency
+    uint64_t error;  // count - error is a lower bound
+};
+
+// Space-Saving summary with fixed amount of counters kept in a min-heap by count.
+// Every key with frequency > total / capacity is guaranteed to be monitored.
+class SpaceSaving {
+public:
+    explicit SpaceSaving(size_t capacity);
+
+    void add(uint32_t key);
+
+    // k most frequent, descending by count
+    std::vector<HeavyHitter> top(size_t k) const;
+
+private:
+    void sift_down(size_t pos) noexcept;
+    void place(size_t pos) noexcept;
+
+    size_t capacity_;
+    std::vector<HeavyHitter> heap_;
+    std::unordered_map<uint32_t, size_t> pos_of_;
+};
+
+// Single pass over keys: exact distinct count and top-K heavy hitters
+class IpStats {
+public:
+    // Counters for heavy hitters are oversized to keep estimates of top k tight.
+    // The 512 MiB bitset is mapped only when distinct keys are counted.
+    IpStats(size_t top_k, bool count_distinct) : top_k_(top_k), heavy_hitters_(std::max<size_t>(1024, top_k * 8)) {
+        if (count_distinct) {
+            distinct_.emplace();
+        }
+    }
+
+    void add(uint32_t key) {
+        if (distinct_) {
+            distinct_->insert(key);
+        }
+        if (top_k_ != 0) {
+            heavy_hitters_.add(key);
+        }
+        total_++;
+    }
+
+    size_t total() const noexcept {
+        return total_;
+    }
+
+    // 0 unless distinct keys are counted
+    size_t distinct() const noexcept {
+        return distinct_ ? distinct_->count() : 0;
+    }
+
+    std::vector<HeavyHitter> top() const {
+        return heavy_hitters_.top(top_k_);
+    }
+
+private:
+    size_t top_k_;
+    size_t total_ = 0;
+    std::optional<IpBitset> distinct_;
+    SpaceSaving heavy_hitters_;
+};
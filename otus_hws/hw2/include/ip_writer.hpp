@@ -0,0 +1,52 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Longest dotted quad plus terminator, format_ip never writes more than that
+constexpr size_t MAX_IP_TEXT = 16;
+
+// Writes "a.b.c.d" using precomputed octet texts, returns pointer past the last char
+char* format_ip(uint32_t key, char* out) noexcept;
+
+constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+// Buffered output to a file descriptor, one write(2) per filled buffer
+class IpWriter {
+public:
+    explicit IpWriter(int fd = STDOUT_FILENO, size_t buffer_size = WRITE_BUFFER_SIZE);
+    // flushes what is left, errors are lost here - call flush() to see them
+    ~IpWriter();
+
+    IpWriter(const IpWriter&) = delete;
+    IpWriter& operator=(const IpWriter&) = delete;
+
+    void write_ip(uint32_t key, char terminator = '\n') {
+        if (buffer_.size() - size_ < MAX_IP_TEXT) {
+            flush();
+        }
+        char* end = format_ip(key, buffer_.data() + size_);
+        *end++ = terminator;
+        size_ = static_cast<size_t>(end - buffer_.data());
+    }
+
+    void write_ips(std::span<const uint32_t> keys) {
+        for (uint32_t key : keys) {
+            write_ip(key);
+        }
+    }
+
+    void write(std::string_view text);
+
+    void flush();
+
+private:
+    int fd_;
+    std::vector<char> buffer_;
+    size_t size_ = 0;
+};
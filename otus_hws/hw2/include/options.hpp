@@ -0,0 +1,52 @@
+#pragma once
+
+#include <boost/program_options.hpp>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+
+struct Options {
+    std::string input;  // empty - read stdin
+    size_t threads = 1;
+    std::vector<std::string> prefixes;  // CIDR queries
+    std::string emit_binary;
+    std::string load_binary;
+    bool distinct = false;
+    size_t top = 0;
+    bool help = false;
+};
+
+inline Options parse_options(int argc, char* argv[]) {
+    Options opts;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", po::bool_switch(&opts.help), "show help message")
+        ("input,i", po::value<std::string>(&opts.input), "tsv with ips at first column (mmaped), stdin if not set")
+        ("threads,j", po::value<size_t>(&opts.threads)->default_value(1),
+         "parse, sort and merge in parallel on that many threads")
+        ("prefix,p", po::value<std::vector<std::string>>(&opts.prefixes)->composing(),
+         "print ips of CIDR (e.g. 46.70.0.0/16) instead of hw filters, may be repeated")
+        ("emit-binary", po::value<std::string>(&opts.emit_binary),
+         "write sorted pool with prefix index to file instead of printing")
+        ("load-binary", po::value<std::string>(&opts.load_binary),
+         "mmap pool written by --emit-binary instead of parsing input")
+        ("distinct", po::bool_switch(&opts.distinct), "print exact amount of unique ips (single pass, no sorting)")
+        ("top", po::value<size_t>(&opts.top)->default_value(0), "print N most frequent ips with estimated counts");
+
+    po::positional_options_description positional;
+    positional.add("input", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+    po::notify(vm);
+
+    if (opts.help) {
+        std::cout << desc << std::endl;
+    }
+
+    return opts;
+}
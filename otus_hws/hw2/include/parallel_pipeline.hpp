@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using Chunk = std::pair<const char*, const char*>;
+
+// Sorted pool plus output of the three hw filters, all in descending order
+struct PipelineResult {
+    std::vector<uint32_t> sorted;
+    std::vector<uint32_t> first_is_1;
+    std::vector<uint32_t> first_46_second_70;
+    std::vector<uint32_t> any_is_46;
+};
+
+// Splits [begin, end) into at most `parts` chunks, each one ends right after '\n' (or at end)
+std::vector<Chunk> split_line_aligned(const char* begin, const char* end, size_t parts);
+
+// Every chunk is parsed and radix sorted on its own thread
+std::vector<std::vector<uint32_t>> parse_sorted_runs(const std::vector<Chunk>& chunks);
+
+// Output is partitioned by key ranges, every range is k-way merged on its own thread.
+// Filters are evaluated on the merged stream, no extra pass over the result.
+PipelineResult merge_and_filter(const std::vector<std::vector<uint32_t>>& runs, size_t threads);
+
+PipelineResult run_parallel_pipeline(const char* begin, const char* end, size_t threads);
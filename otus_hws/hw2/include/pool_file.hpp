@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "ip_reader.hpp"
+#include "prefix_index.hpp"
+
+// Pool file layout (native byte order):
+//   PoolHeader | prefix table, TABLE_SIZE x uint64_t | keys, count x uint32_t sorted descending
+struct PoolHeader {
+    static constexpr char MAGIC[8] = {'I', 'P', 'P', 'O', 'O', 'L', '\0', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t count;
+    uint64_t table_offset;
+    uint64_t keys_offset;
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(PoolHeader) == 64);
+
+void write_pool_file(const std::string& file_path, std::span<const uint32_t> sorted_keys, const PrefixIndex& index);
+
+// mmaped pool file, keys and index are views into the mapping
+class PoolFile {
+public:
+    explicit PoolFile(const std::string& file_path);
+
+    std::span<const uint32_t> keys() const noexcept {
+        return keys_;
+    }
+
+    const PrefixIndex& index() const noexcept {
+        return index_;
+    }
+
+private:
+    static std::span<const uint32_t> map_keys(const MappedFile& file, const std::string& file_path);
+    static std::span<const uint64_t> map_table(const MappedFile& file);
+
+    MappedFile file_;
+    std::span<const uint32_t> keys_;
+    PrefixIndex index_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+struct Cidr {
+    uint32_t network;
+    unsigned bits;  // 0..32
+};
+
+// "46.70.0.0/16", bare address means /32
+Cidr parse_cidr(const std::string& cidr);
+
+// Offset table by first two octets over keys sorted in descending order.
+// Keys are not copied and must outlive the index.
+class PrefixIndex {
+public:
+    static constexpr size_t TABLE_SIZE = (1 << 16) + 1;
+
+    explicit PrefixIndex(std::span<const uint32_t> sorted_keys);
+    // Reuses prebuilt table (e.g. mmaped from pool file), table must outlive the index
+    PrefixIndex(std::span<const uint32_t> sorted_keys, std::span<const uint64_t> table);
+
+    // at_least_ may point to own_table_, copy would dangle
+    PrefixIndex(const PrefixIndex&) = delete;
+    PrefixIndex& operator=(const PrefixIndex&) = delete;
+    PrefixIndex(PrefixIndex&&) = default;
+    PrefixIndex& operator=(PrefixIndex&&) = default;
+
+    std::span<const uint32_t> prefix(uint8_t first) const noexcept;
+    std::span<const uint32_t> prefix(uint8_t first, uint8_t second) const noexcept;
+    std::span<const uint32_t> cidr(const Cidr& cidr) const noexcept;
+    // all keys in [low, high]
+    std::span<const uint32_t> range(uint32_t low, uint32_t high) const noexcept;
+
+    std::span<const uint64_t> table() const noexcept {
+        return at_least_;
+    }
+
+private:
+    // index of the first key <= value
+    size_t lower(uint32_t value) const noexcept;
+
+    std::span<const uint32_t> keys_;
+    std::vector<uint64_t> own_table_;
+    // at_least_[h] - amount of keys whose first two octets are >= h
+    std::span<const uint64_t> at_least_;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LSD radix sort by 8-bit digits, descending order (same order as lexicographically_sort)
+void radix_sort_desc(std::vector<uint32_t>& keys);
+void radix_sort_desc(uint32_t* keys, uint32_t* buffer, size_t size);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+enum class SimdLevel { SCALAR = 0, SSE2, AVX2 };
+
+// Kernels write matching keys to `out` (must fit `size` keys) preserving order, return amount of matches
+struct FilterKernels {
+    const char* name;
+    // any of four octets == byte
+    size_t (*any_byte_eq)(const uint32_t* keys, size_t size, uint8_t byte, uint32_t* out);
+    // (key & mask) == prefix, e.g. mask 0xFFFF0000 prefix 0x2E460000 for 46.70.*
+    size_t (*prefix_eq)(const uint32_t* keys, size_t size, uint32_t prefix, uint32_t mask, uint32_t* out);
+};
+
+SimdLevel detect_simd_level() noexcept;
+// Best kernels for the current cpu, resolved once
+const FilterKernels& filter_kernels() noexcept;
+// Kernels of exact level, level must be supported by the cpu
+const FilterKernels& filter_kernels(SimdLevel level) noexcept;
+
+std::vector<uint32_t> filter_any_byte_eq(std::span<const uint32_t> keys, uint8_t byte);
+std::vector<uint32_t> filter_prefix_eq(std::span<const uint32_t> keys, uint32_t prefix, uint32_t mask);
@@ -17,6 +17,8 @@
 #include <vector>
 
 #include "ip_filter.hpp"
+#include "ip_writer.hpp"
+#include "radix_sort.hpp"
 
 std::vector<std::string> split(const std::string& str, char d) {
     std::vector<std::string> r;
@@ -35,9 +37,8 @@ std::vector<std::string> split(const std::string& str, char d) {
     return r;
 }
 
-void lexicographically_sort(std::vector<Ip>& ip_pool) {
-    std::sort(ip_pool.begin(), ip_pool.end(),
-              [](const Ip& ip1, const Ip& ip2) { return ip1 > ip2; });
+void lexicographically_sort(std::vector<uint32_t>& keys) {
+    radix_sort_desc(keys);
 }
 
 std::vector<Ip> read_from_cmd() {
@@ -81,37 +82,13 @@ Ip::Ip(const std::string& ip) {
         throw std::runtime_error("Bad IP: " + ip);
 #endif
     }
+    collapsed_ip_ = 0;
     for (int i = 0; i < 4; i++) {
-        ip_[i] = static_cast<uint8_t>(std::stoi(v[i]));
+        collapsed_ip_ = (collapsed_ip_ << 8) | static_cast<uint8_t>(std::stoi(v[i]));
     }
-
-    collapsed_ip_ = (static_cast<uint32_t>(ip_[3])) | (static_cast<uint32_t>(ip_[2]) << 8) |
-                    (static_cast<uint32_t>(ip_[1]) << 16) | (static_cast<uint32_t>(ip_[0]) << 24);
 }
 
-Ip::Ip(const Ip& ip) {
-    if (this == &ip) {
-        return;
-    }
-    for (uint8_t i = 0; i < 4; i++) {
-        ip_[i] = ip.ip_[i];
-    }
-
-    collapsed_ip_ = ip.collapsed_ip_;
-}
-
-Ip& Ip::operator=(const Ip& ip) {
-    if (this == &ip) {
-        return *this;
-    }
-
-    for (uint8_t i = 0; i < 4; i++) {
-        ip_[i] = ip.ip_[i];
-    }
-
-    collapsed_ip_ = ip.collapsed_ip_;
-
-    return *this;
+Ip::Ip(uint32_t collapsed_ip) noexcept : collapsed_ip_(collapsed_ip) {
 }
 
 bool Ip::operator>(const Ip& ip) const noexcept {
@@ -131,14 +108,8 @@ bool Ip::operator!=(const Ip& ip) const noexcept {
 }
 
 std::string Ip::str() const noexcept {
-#if __cplusplus >= 202302L
-    return std::format("{}.{}.{}.{}", ip_[0], ip_[1], ip_[2], ip_[3]);
-#else
-    std::ostringstream ostream;
-    ostream << static_cast<uint32_t>(ip_[0]) << '.' << static_cast<uint32_t>(ip_[1]) << '.'
-            << static_cast<uint32_t>(ip_[2]) << '.' << static_cast<uint32_t>(ip_[3]);
-    return ostream.str();
-#endif
+    char text[MAX_IP_TEXT];
+    return std::string(text, format_ip(collapsed_ip_, text));
 }
 
 std::ostream& operator<<(std::ostream& os, const Ip& ip) {
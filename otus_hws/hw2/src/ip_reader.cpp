@@ -0,0 +1,61 @@
+#include "ip_reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+MappedFile::MappedFile(const std::string& file_path) {
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("File " + file_path + " not found!");
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat " + file_path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+
+    if (size_ != 0) {
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to mmap " + file_path);
+        }
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+    // mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+std::vector<uint32_t> map_from_file(const std::string& file_path) {
+    MappedFile file(file_path);
+
+    std::vector<uint32_t> keys;
+    // ~16 bytes per log line is a cheap lower bound that saves most of the regrowth
+    keys.reserve(file.size() / 16);
+
+    for_each_ip_final(file.begin(), file.end(), [&keys](uint32_t collapsed_ip) { keys.push_back(collapsed_ip); });
+
+    return keys;
+}
+
+std::vector<uint32_t> read_from_stream(std::istream& input, size_t chunk_size) {
+    std::vector<uint32_t> keys;
+    for_each_ip_in_stream(input, [&keys](uint32_t collapsed_ip) { keys.push_back(collapsed_ip); }, chunk_size);
+    return keys;
+}
@@ -0,0 +1,90 @@
+#include "ip_stats.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+IpBitset::IpBitset() {
+    void* words = ::mmap(nullptr, BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (words == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    words_ = static_cast<uint64_t*>(words);
+}
+
+IpBitset::~IpBitset() {
+    ::munmap(words_, BYTES);
+}
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {
+    heap_.reserve(capacity_);
+    pos_of_.reserve(capacity_);
+}
+
+void SpaceSaving::place(size_t pos) noexcept {
+    pos_of_[heap_[pos].key] = pos;
+}
+
+void SpaceSaving::sift_down(size_t pos) noexcept {
+    const size_t size = heap_.size();
+    for (;;) {
+        size_t smallest = pos;
+        const size_t left = 2 * pos + 1;
+        const size_t right = left + 1;
+        if (left < size && heap_[left].count < heap_[smallest].count) {
+            smallest = left;
+        }
+        if (right < size && heap_[right].count < heap_[smallest].count) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            return;
+        }
+        std::swap(heap_[pos], heap_[smallest]);
+        place(pos);
+        place(smallest);
+        pos = smallest;
+    }
+}
+
+void SpaceSaving::add(uint32_t key) {
+    auto it = pos_of_.find(key);
+    if (it != pos_of_.end()) {
+        // count only grows, so the entry can only move down in min-heap
+        heap_[it->second].count++;
+        sift_down(it->second);
+        return;
+    }
+
+    if (heap_.size() < capacity_) {
+        // count 1 is the minimal one, sift it up
+        heap_.push_back(HeavyHitter{key, 1, 0});
+        size_t pos = heap_.size() - 1;
+        while (pos != 0 && heap_[(pos - 1) / 2].count > heap_[pos].count) {
+            std::swap(heap_[pos], heap_[(pos - 1) / 2]);
+            place(pos);
+            pos = (pos - 1) / 2;
+        }
+        place(pos);
+        return;
+    }
+
+    // evict the minimum, newcomer inherits its count as error
+    HeavyHitter& root = heap_.front();
+    pos_of_.erase(root.key);
+    root = HeavyHitter{key, root.count + 1, root.count};
+    place(0);
+    sift_down(0);
+}
+
+std::vector<HeavyHitter> SpaceSaving::top(size_t k) const {
+    std::vector<HeavyHitter> result = heap_;
+    k = std::min(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(k), result.end(),
+                      [](const HeavyHitter& a, const HeavyHitter& b) { return a.count > b.count || (a.count == b.count && a.key > b.key); });
+    result.resize(k);
+    return result;
+}
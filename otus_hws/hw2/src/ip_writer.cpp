@@ -0,0 +1,95 @@
+#include "ip_writer.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct OctetText {
+    char chars[3];
+    uint8_t size;
+};
+
+constexpr std::array<OctetText, 256> make_octet_table() {
+    std::array<OctetText, 256> table{};
+    for (unsigned value = 0; value < 256; value++) {
+        OctetText& text = table[value];
+        if (value >= 100) {
+            text = OctetText{{static_cast<char>('0' + value / 100), static_cast<char>('0' + value / 10 % 10),
+                              static_cast<char>('0' + value % 10)},
+                             3};
+        } else if (value >= 10) {
+            text = OctetText{{static_cast<char>('0' + value / 10), static_cast<char>('0' + value % 10), '\0'}, 2};
+        } else {
+            text = OctetText{{static_cast<char>('0' + value), '\0', '\0'}, 1};
+        }
+    }
+    return table;
+}
+
+constexpr std::array<OctetText, 256> OCTET_TABLE = make_octet_table();
+
+char* put_octet(uint8_t octet, char* out) noexcept {
+    // always copies 3 chars, the unused tail is overwritten by the next one
+    const OctetText& text = OCTET_TABLE[octet];
+    std::memcpy(out, text.chars, 3);
+    return out + text.size;
+}
+
+}  // namespace
+
+char* format_ip(uint32_t key, char* out) noexcept {
+    out = put_octet(static_cast<uint8_t>(key >> 24), out);
+    *out++ = '.';
+    out = put_octet(static_cast<uint8_t>(key >> 16), out);
+    *out++ = '.';
+    out = put_octet(static_cast<uint8_t>(key >> 8), out);
+    *out++ = '.';
+    return put_octet(static_cast<uint8_t>(key), out);
+}
+
+IpWriter::IpWriter(int fd, size_t buffer_size) : fd_(fd), buffer_(std::max(buffer_size, MAX_IP_TEXT)) {
+}
+
+IpWriter::~IpWriter() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void IpWriter::write(std::string_view text) {
+    while (!text.empty()) {
+        if (size_ == buffer_.size()) {
+            flush();
+        }
+        const size_t part = std::min(text.size(), buffer_.size() - size_);
+        std::memcpy(buffer_.data() + size_, text.data(), part);
+        size_ += part;
+        text.remove_prefix(part);
+    }
+}
+
+void IpWriter::flush() {
+    const char* data = buffer_.data();
+    size_t left = size_;
+    // buffer is considered consumed even if write fails
+    size_ = 0;
+    while (left != 0) {
+        ssize_t written = ::write(fd_, data, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write output: ") + std::strerror(errno));
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+}
@@ -1,48 +1,140 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <iterator>
+#include <span>
 #include <stdexcept>
+#include <string>
 
 #include "ip_filter.hpp"
+#include "ip_reader.hpp"
+#include "ip_stats.hpp"
+#include "ip_writer.hpp"
+#include "options.hpp"
+#include "parallel_pipeline.hpp"
+#include "pool_file.hpp"
+#include "prefix_index.hpp"
+#include "simd_filter.hpp"
 
-int main(int argc, char** argv) {
-    (void) argv;
-    (void) argc;
-    // if (argc != 2) {
-    //     throw std::runtime_error("I expect csv with ips at second argument...");
-    // }
+// one block of output per CIDR
+void print_queries(IpWriter& out, const PrefixIndex& index, const std::vector<std::string>& prefixes) {
+    std::vector<Cidr> queries;
+    for (const auto& prefix : prefixes) {
+        queries.push_back(parse_cidr(prefix));
+    }
+
+    for (const auto& query : queries) {
+        out.write_ips(index.cidr(query));
+    }
+}
+
+void print_hw_filters(IpWriter& out, std::span<const uint32_t> sorted_keys, const PrefixIndex& index) {
+    // print lex sorted
+    out.write_ips(sorted_keys);
+
+    // [0]=1
+    out.write_ips(index.prefix(1));
+
+    // [0]=46 [1]=70
+    out.write_ips(index.prefix(46, 70));
+
+    // [any]=46
+    out.write_ips(filter_any_byte_eq(sorted_keys, 46));
+}
+
+void output(std::span<const uint32_t> sorted_keys, const PrefixIndex& index, const Options& opts) {
+    if (!opts.emit_binary.empty()) {
+        write_pool_file(opts.emit_binary, sorted_keys, index);
+        return;
+    }
 
+    IpWriter out;
+    if (!opts.prefixes.empty()) {
+        print_queries(out, index, opts.prefixes);
+    } else {
+        print_hw_filters(out, sorted_keys, index);
+    }
+    out.flush();
+}
+
+void run_parallel(const Options& opts) {
+    PipelineResult result;
+    if (opts.input.empty()) {
+        const std::string input{std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>()};
+        result = run_parallel_pipeline(input.data(), input.data() + input.size(), opts.threads);
+    } else {
+        MappedFile file(opts.input);
+        result = run_parallel_pipeline(file.begin(), file.end(), opts.threads);
+    }
+
+    if (!opts.emit_binary.empty() || !opts.prefixes.empty()) {
+        output(result.sorted, PrefixIndex(result.sorted), opts);
+        return;
+    }
+
+    // filters were already evaluated by the merge
+    IpWriter out;
+    out.write_ips(result.sorted);
+    out.write_ips(result.first_is_1);
+    out.write_ips(result.first_46_second_70);
+    out.write_ips(result.any_is_46);
+    out.flush();
+}
+
+// Streams input straight into counters, pool is never materialized
+void run_stats(const Options& opts) {
+    IpStats stats(opts.top, opts.distinct);
+    auto add = [&stats](uint32_t key) { stats.add(key); };
+    if (opts.input.empty()) {
+        for_each_ip_in_stream(std::cin, add);
+    } else {
+        MappedFile file(opts.input);
+        for_each_ip_final(file.begin(), file.end(), add);
+    }
+
+    IpWriter out;
+    if (opts.distinct) {
+        out.write("distinct\t" + std::to_string(stats.distinct()) + "\n");
+    }
+    // count is only an upper bound, count - error is the guaranteed frequency
+    for (const auto& heavy_hitter : stats.top()) {
+        out.write_ip(heavy_hitter.key, '\t');
+        out.write(std::to_string(heavy_hitter.count - heavy_hitter.error) + "\t" + std::to_string(heavy_hitter.count) + "\n");
+    }
+    out.flush();
+}
+
+int main(int argc, char** argv) {
     try {
-        auto ip_pool = read_from_cmd();
-        // auto ip_pool = read_from_file(argv[1]);
-
-        lexicographically_sort(ip_pool);
-
-        // print lex sorted
-        std::for_each(ip_pool.cbegin(), ip_pool.cend(),
-                      [](const Ip& ip) { std::cout << ip.str() << std::endl; });
-
-        // [0]=1
-        std::for_each(ip_pool.cbegin(), ip_pool.cend(), [](const Ip& ip) {
-            if (ip.ip_[0] == 1) {
-                std::cout << ip.str() << std::endl;
-            }
-        });
-
-        // [0]=46 [1]=70
-        std::for_each(ip_pool.cbegin(), ip_pool.cend(), [](const Ip& ip) {
-            if ((ip.ip_[0] == 46) && (ip.ip_[1] == 70)) {
-                std::cout << ip.str() << std::endl;
-            }
-        });
-
-        // [any]=46
-        std::for_each(ip_pool.cbegin(), ip_pool.cend(), [](const Ip& ip) {
-            if (std::any_of(ip.ip_.cbegin(), ip.ip_.cend(),
-                            [](const int& ip_part) { return ip_part == 46; })) {
-                std::cout << ip.str() << std::endl;
-            }
-        });
+        Options opts = parse_options(argc, argv);
+        if (opts.help) {
+            return 0;
+        }
+
+        std::ios::sync_with_stdio(false);
+
+        if (opts.distinct || opts.top != 0) {
+            run_stats(opts);
+            return 0;
+        }
+
+        if (!opts.load_binary.empty()) {
+            PoolFile pool(opts.load_binary);
+            output(pool.keys(), pool.index(), opts);
+            return 0;
+        }
+
+        if (opts.threads > 1) {
+            run_parallel(opts);
+            return 0;
+        }
+
+        // packed keys all the way, Ip text is only produced by the writer
+        auto keys = opts.input.empty() ? read_from_stream(std::cin) : map_from_file(opts.input);
+
+        lexicographically_sort(keys);
+
+        output(keys, PrefixIndex(keys), opts);
 
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
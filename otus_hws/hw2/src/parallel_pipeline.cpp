@@ -0,0 +1,180 @@
+#include "parallel_pipeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <queue>
+#include <vector>
+
+#include "ip_reader.hpp"
+#include "radix_sort.hpp"
+
+namespace {
+
+// samples per run used to choose range splitters
+constexpr size_t SAMPLES_PER_RUN = 64;
+
+// Splitters s_1 >= s_2 >= ... s_{parts-1}; range p holds keys in (s_{p+1}, s_p]
+std::vector<uint32_t> choose_splitters(const std::vector<std::vector<uint32_t>>& runs, size_t parts) {
+    std::vector<uint32_t> samples;
+    for (const auto& run : runs) {
+        if (run.empty()) {
+            continue;
+        }
+        size_t step = std::max<size_t>(1, run.size() / SAMPLES_PER_RUN);
+        for (size_t i = 0; i < run.size(); i += step) {
+            samples.push_back(run[i]);
+        }
+    }
+    std::sort(samples.begin(), samples.end(), std::greater<uint32_t>());
+
+    std::vector<uint32_t> splitters;
+    for (size_t p = 1; p < parts && !samples.empty(); p++) {
+        splitters.push_back(samples[p * samples.size() / parts]);
+    }
+    return splitters;
+}
+
+// Index of the first key of `run` that is <= splitter
+size_t lower_split(const std::vector<uint32_t>& run, uint32_t splitter) {
+    auto it = std::partition_point(run.begin(), run.end(), [splitter](uint32_t key) { return key > splitter; });
+    return static_cast<size_t>(it - run.begin());
+}
+
+// Filters only, `sorted` is written by the caller
+void filter(PipelineResult& result, uint32_t key) {
+    uint8_t first = static_cast<uint8_t>(key >> 24);
+    uint8_t second = static_cast<uint8_t>(key >> 16);
+    if (first == 1) {
+        result.first_is_1.push_back(key);
+    }
+    if (first == 46 && second == 70) {
+        result.first_46_second_70.push_back(key);
+    }
+    if (first == 46 || second == 46 || static_cast<uint8_t>(key >> 8) == 46 || static_cast<uint8_t>(key) == 46) {
+        result.any_is_46.push_back(key);
+    }
+}
+
+struct Cursor {
+    const uint32_t* cur;
+    const uint32_t* end;
+
+    bool operator<(const Cursor& other) const noexcept {
+        // max-heap by current key
+        return *cur < *other.cur;
+    }
+};
+
+PipelineResult merge_range(const std::vector<std::vector<uint32_t>>& runs,
+                           const std::vector<size_t>& from,
+                           const std::vector<size_t>& to,
+                           uint32_t* out) {
+    PipelineResult result;
+    std::priority_queue<Cursor> heap;
+    for (size_t r = 0; r < runs.size(); r++) {
+        if (from[r] != to[r]) {
+            heap.push(Cursor{runs[r].data() + from[r], runs[r].data() + to[r]});
+        }
+    }
+
+    while (!heap.empty()) {
+        Cursor top = heap.top();
+        heap.pop();
+        *out++ = *top.cur;
+        filter(result, *top.cur);
+        if (++top.cur != top.end) {
+            heap.push(top);
+        }
+    }
+    return result;
+}
+
+void append(std::vector<uint32_t>& to, const std::vector<uint32_t>& from) {
+    to.insert(to.end(), from.begin(), from.end());
+}
+
+}  // namespace
+
+std::vector<Chunk> split_line_aligned(const char* begin, const char* end, size_t parts) {
+    std::vector<Chunk> chunks;
+    const size_t size = static_cast<size_t>(end - begin);
+    parts = std::max<size_t>(1, parts);
+
+    const char* chunk_begin = begin;
+    for (size_t p = 1; p <= parts && chunk_begin != end; p++) {
+        const char* chunk_end = end;
+        if (p != parts) {
+            const char* approx = std::max(chunk_begin, begin + p * size / parts);
+            const char* eol = static_cast<const char*>(std::memchr(approx, '\n', static_cast<size_t>(end - approx)));
+            chunk_end = eol ? eol + 1 : end;
+        }
+        chunks.emplace_back(chunk_begin, chunk_end);
+        chunk_begin = chunk_end;
+    }
+    return chunks;
+}
+
+std::vector<std::vector<uint32_t>> parse_sorted_runs(const std::vector<Chunk>& chunks) {
+    std::vector<std::future<std::vector<uint32_t>>> futures;
+    for (const auto& [chunk_begin, chunk_end] : chunks) {
+        futures.push_back(std::async(std::launch::async, [chunk_begin, chunk_end]() {
+            std::vector<uint32_t> run;
+            run.reserve(static_cast<size_t>(chunk_end - chunk_begin) / 16);
+            for_each_ip_final(chunk_begin, chunk_end, [&run](uint32_t collapsed_ip) { run.push_back(collapsed_ip); });
+            radix_sort_desc(run);
+            return run;
+        }));
+    }
+
+    std::vector<std::vector<uint32_t>> runs;
+    for (auto& future : futures) {
+        runs.push_back(future.get());
+    }
+    return runs;
+}
+
+PipelineResult merge_and_filter(const std::vector<std::vector<uint32_t>>& runs, size_t threads) {
+    const auto splitters = choose_splitters(runs, std::max<size_t>(1, threads));
+    const size_t ranges = splitters.size() + 1;
+
+    // bounds[p][r] - first index of run r that belongs to range p
+    std::vector<std::vector<size_t>> bounds(ranges + 1, std::vector<size_t>(runs.size(), 0));
+    for (size_t r = 0; r < runs.size(); r++) {
+        for (size_t p = 1; p < ranges; p++) {
+            bounds[p][r] = lower_split(runs[r], splitters[p - 1]);
+        }
+        bounds[ranges][r] = runs[r].size();
+    }
+
+    PipelineResult result;
+    size_t total = 0;
+    for (const auto& run : runs) {
+        total += run.size();
+    }
+    result.sorted.resize(total);
+
+    // ranges are disjoint, so every thread writes its own slice of the output
+    std::vector<std::future<PipelineResult>> futures;
+    uint32_t* out = result.sorted.data();
+    for (size_t p = 0; p < ranges; p++) {
+        futures.push_back(std::async(std::launch::async,
+                                     [&runs, &bounds, p, out]() { return merge_range(runs, bounds[p], bounds[p + 1], out); }));
+        for (size_t r = 0; r < runs.size(); r++) {
+            out += bounds[p + 1][r] - bounds[p][r];
+        }
+    }
+
+    for (auto& future : futures) {
+        PipelineResult part = future.get();
+        append(result.first_is_1, part.first_is_1);
+        append(result.first_46_second_70, part.first_46_second_70);
+        append(result.any_is_46, part.any_is_46);
+    }
+    return result;
+}
+
+PipelineResult run_parallel_pipeline(const char* begin, const char* end, size_t threads) {
+    return merge_and_filter(parse_sorted_runs(split_line_aligned(begin, end, threads)), threads);
+}
@@ -0,0 +1,77 @@
+#include "pool_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr uint64_t TABLE_OFFSET = sizeof(PoolHeader);
+constexpr uint64_t KEYS_OFFSET = TABLE_OFFSET + PrefixIndex::TABLE_SIZE * sizeof(uint64_t);
+
+const PoolHeader& header_of(const MappedFile& file) {
+    return *reinterpret_cast<const PoolHeader*>(file.begin());
+}
+
+}  // namespace
+
+void write_pool_file(const std::string& file_path, std::span<const uint32_t> sorted_keys, const PrefixIndex& index) {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open " + file_path + " for writing");
+    }
+
+    PoolHeader header{};
+    std::memcpy(header.magic, PoolHeader::MAGIC, sizeof(header.magic));
+    header.version = PoolHeader::VERSION;
+    header.byte_order = PoolHeader::BYTE_ORDER_MARK;
+    header.count = sorted_keys.size();
+    header.table_offset = TABLE_OFFSET;
+    header.keys_offset = KEYS_OFFSET;
+
+    const auto table = index.table();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size_bytes()));
+    file.write(reinterpret_cast<const char*>(sorted_keys.data()), static_cast<std::streamsize>(sorted_keys.size_bytes()));
+
+    if (!file) {
+        throw std::runtime_error("Failed to write " + file_path);
+    }
+}
+
+PoolFile::PoolFile(const std::string& file_path)
+    : file_(file_path), keys_(map_keys(file_, file_path)), index_(keys_, map_table(file_)) {
+}
+
+std::span<const uint32_t> PoolFile::map_keys(const MappedFile& file, const std::string& file_path) {
+    if (file.size() < sizeof(PoolHeader)) {
+        throw std::runtime_error("Not an ip pool file: " + file_path);
+    }
+
+    const PoolHeader& header = header_of(file);
+    if (std::memcmp(header.magic, PoolHeader::MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not an ip pool file: " + file_path);
+    }
+    if (header.version != PoolHeader::VERSION) {
+        throw std::runtime_error("Unsupported ip pool version " + std::to_string(header.version) + ": " + file_path);
+    }
+    if (header.byte_order != PoolHeader::BYTE_ORDER_MARK) {
+        throw std::runtime_error("Ip pool written with other byte order: " + file_path);
+    }
+    // count is bounded first, so the size check below can't overflow
+    if (header.table_offset != TABLE_OFFSET || header.keys_offset != KEYS_OFFSET || file.size() < KEYS_OFFSET ||
+        header.count > (file.size() - KEYS_OFFSET) / sizeof(uint32_t) ||
+        file.size() != KEYS_OFFSET + header.count * sizeof(uint32_t)) {
+        throw std::runtime_error("Corrupted ip pool file: " + file_path);
+    }
+
+    const auto* keys = reinterpret_cast<const uint32_t*>(file.begin() + header.keys_offset);
+    return {keys, static_cast<size_t>(header.count)};
+}
+
+std::span<const uint64_t> PoolFile::map_table(const MappedFile& file) {
+    // header was validated by map_keys
+    const auto* table = reinterpret_cast<const uint64_t*>(file.begin() + header_of(file).table_offset);
+    return {table, PrefixIndex::TABLE_SIZE};
+}
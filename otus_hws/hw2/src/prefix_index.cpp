@@ -0,0 +1,93 @@
+#include "prefix_index.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "ip_reader.hpp"
+
+Cidr parse_cidr(const std::string& cidr) {
+    const char* begin = cidr.data();
+    const char* end = begin + cidr.size();
+
+    Cidr result{0, 32};
+    const char* cur = parse_ip(begin, end, result.network);
+    if (cur && cur != end) {
+        if (*cur != '/' || ++cur == end) {
+            cur = nullptr;
+        } else {
+            unsigned bits = 0;
+            for (; cur != end && bits <= 32; ++cur) {
+                if (*cur < '0' || *cur > '9') {
+                    break;
+                }
+                bits = bits * 10 + static_cast<unsigned>(*cur - '0');
+            }
+            result.bits = bits;
+        }
+    }
+    if (!cur || cur != end || result.bits > 32) {
+        throw std::runtime_error("Bad CIDR: " + cidr);
+    }
+    return result;
+}
+
+PrefixIndex::PrefixIndex(std::span<const uint32_t> sorted_keys) : keys_(sorted_keys), own_table_(TABLE_SIZE, 0) {
+    for (uint32_t key : keys_) {
+        own_table_[key >> 16]++;
+    }
+    // suffix sums: own_table_[TABLE_SIZE - 1] stays 0
+    for (size_t h = TABLE_SIZE - 1; h-- > 0;) {
+        own_table_[h] += own_table_[h + 1];
+    }
+    at_least_ = own_table_;
+}
+
+PrefixIndex::PrefixIndex(std::span<const uint32_t> sorted_keys, std::span<const uint64_t> table)
+    : keys_(sorted_keys), at_least_(table) {
+    if (table.size() != TABLE_SIZE || table[0] != keys_.size() || table[TABLE_SIZE - 1] != 0) {
+        throw std::runtime_error("Prefix table does not match keys");
+    }
+    // entries are used as subspan bounds: counts must not grow with the prefix
+    if (std::adjacent_find(table.begin(), table.end(), std::less<uint64_t>()) != table.end()) {
+        throw std::runtime_error("Prefix table is not monotonic");
+    }
+}
+
+size_t PrefixIndex::lower(uint32_t value) const noexcept {
+    // only the bucket of `value` has to be searched
+    const uint32_t bucket = value >> 16;
+    auto begin = keys_.begin() + static_cast<std::ptrdiff_t>(at_least_[bucket + 1]);
+    auto end = keys_.begin() + static_cast<std::ptrdiff_t>(at_least_[bucket]);
+    auto it = std::partition_point(begin, end, [value](uint32_t key) { return key > value; });
+    return static_cast<size_t>(it - keys_.begin());
+}
+
+std::span<const uint32_t> PrefixIndex::range(uint32_t low, uint32_t high) const noexcept {
+    if (low > high) {
+        return {};
+    }
+    const size_t from = lower(high);
+    const size_t to = low == 0 ? keys_.size() : lower(low - 1);
+    return keys_.subspan(from, to - from);
+}
+
+std::span<const uint32_t> PrefixIndex::prefix(uint8_t first) const noexcept {
+    const size_t from = at_least_[(first + 1u) << 8];
+    const size_t to = at_least_[first << 8];
+    return keys_.subspan(from, to - from);
+}
+
+std::span<const uint32_t> PrefixIndex::prefix(uint8_t first, uint8_t second) const noexcept {
+    const uint32_t bucket = (static_cast<uint32_t>(first) << 8) | second;
+    const size_t from = at_least_[bucket + 1];
+    const size_t to = at_least_[bucket];
+    return keys_.subspan(from, to - from);
+}
+
+std::span<const uint32_t> PrefixIndex::cidr(const Cidr& cidr) const noexcept {
+    const uint32_t mask = cidr.bits == 0 ? 0 : ~0u << (32 - cidr.bits);
+    const uint32_t low = cidr.network & mask;
+    return range(low, low | ~mask);
+}
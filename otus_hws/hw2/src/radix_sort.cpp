@@ -0,0 +1,70 @@
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace {
+
+constexpr size_t DIGIT_BITS = 8;
+constexpr size_t BUCKETS = 1 << DIGIT_BITS;
+constexpr size_t PASSES = 32 / DIGIT_BITS;
+// below that histogram setup costs more than comparisons
+constexpr size_t RADIX_THRESHOLD = 256;
+
+uint32_t digit(uint32_t key, size_t pass) noexcept {
+    return (key >> (pass * DIGIT_BITS)) & (BUCKETS - 1);
+}
+
+}  // namespace
+
+void radix_sort_desc(uint32_t* keys, uint32_t* buffer, size_t size) {
+    if (size < RADIX_THRESHOLD) {
+        std::sort(keys, keys + size, std::greater<uint32_t>());
+        return;
+    }
+
+    // all histograms are collected in a single pass over the input
+    std::array<std::array<size_t, BUCKETS>, PASSES> histograms{};
+    for (size_t i = 0; i < size; i++) {
+        for (size_t pass = 0; pass < PASSES; pass++) {
+            histograms[pass][digit(keys[i], pass)]++;
+        }
+    }
+
+    uint32_t* src = keys;
+    uint32_t* dst = buffer;
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        auto& histogram = histograms[pass];
+        // every key has the same digit - pass would be an identity permutation
+        if (histogram[digit(src[0], pass)] == size) {
+            continue;
+        }
+
+        // descending: bucket 255 goes first
+        size_t offset = 0;
+        for (size_t bucket = BUCKETS; bucket-- > 0;) {
+            size_t count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < size; i++) {
+            uint32_t key = src[i];
+            dst[histogram[digit(key, pass)]++] = key;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != keys) {
+        std::copy(src, src + size, keys);
+    }
+}
+
+void radix_sort_desc(std::vector<uint32_t>& keys) {
+    std::vector<uint32_t> buffer(keys.size());
+    radix_sort_desc(keys.data(), buffer.data(), keys.size());
+}
@@ -0,0 +1,164 @@
+#include "simd_filter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IP_FILTER_X86 1
+#endif
+
+namespace {
+
+bool has_byte(uint32_t key, uint8_t byte) noexcept {
+    // classic "haszero" trick on key ^ byte broadcast
+    uint32_t x = key ^ (0x01010101u * byte);
+    return ((x - 0x01010101u) & ~x & 0x80808080u) != 0;
+}
+
+size_t any_byte_eq_scalar(const uint32_t* keys, size_t size, uint8_t byte, uint32_t* out) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+        out[count] = keys[i];
+        count += has_byte(keys[i], byte);
+    }
+    return count;
+}
+
+size_t prefix_eq_scalar(const uint32_t* keys, size_t size, uint32_t prefix, uint32_t mask, uint32_t* out) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+        out[count] = keys[i];
+        count += (keys[i] & mask) == prefix;
+    }
+    return count;
+}
+
+#ifdef IP_FILTER_X86
+
+// writes keys selected by bits of `matches` (bit i - keys[i])
+size_t store_matches(const uint32_t* keys, unsigned matches, uint32_t* out) {
+    size_t count = 0;
+    while (matches) {
+        out[count++] = keys[__builtin_ctz(matches)];
+        matches &= matches - 1;
+    }
+    return count;
+}
+
+size_t any_byte_eq_sse2(const uint32_t* keys, size_t size, uint8_t byte, uint32_t* out) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(byte));
+    const __m128i zero = _mm_setzero_si128();
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        __m128i bytes_eq = _mm_cmpeq_epi8(block, needle);
+        // lane is all ones when none of its bytes matched
+        __m128i no_match = _mm_cmpeq_epi32(bytes_eq, zero);
+        unsigned matches = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(no_match))) & 0xFu;
+        count += store_matches(keys + i, matches, out + count);
+    }
+    return count + any_byte_eq_scalar(keys + i, size - i, byte, out + count);
+}
+
+size_t prefix_eq_sse2(const uint32_t* keys, size_t size, uint32_t prefix, uint32_t mask, uint32_t* out) {
+    const __m128i prefix_v = _mm_set1_epi32(static_cast<int>(prefix));
+    const __m128i mask_v = _mm_set1_epi32(static_cast<int>(mask));
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(block, mask_v), prefix_v);
+        unsigned matches = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+        count += store_matches(keys + i, matches, out + count);
+    }
+    return count + prefix_eq_scalar(keys + i, size - i, prefix, mask, out + count);
+}
+
+__attribute__((target("avx2"))) size_t any_byte_eq_avx2(const uint32_t* keys, size_t size, uint8_t byte, uint32_t* out) {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(byte));
+    const __m256i zero = _mm256_setzero_si256();
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        __m256i bytes_eq = _mm256_cmpeq_epi8(block, needle);
+        __m256i no_match = _mm256_cmpeq_epi32(bytes_eq, zero);
+        unsigned matches = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(no_match))) & 0xFFu;
+        count += store_matches(keys + i, matches, out + count);
+    }
+    return count + any_byte_eq_scalar(keys + i, size - i, byte, out + count);
+}
+
+__attribute__((target("avx2"))) size_t prefix_eq_avx2(const uint32_t* keys,
+                                                      size_t size,
+                                                      uint32_t prefix,
+                                                      uint32_t mask,
+                                                      uint32_t* out) {
+    const __m256i prefix_v = _mm256_set1_epi32(static_cast<int>(prefix));
+    const __m256i mask_v = _mm256_set1_epi32(static_cast<int>(mask));
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(block, mask_v), prefix_v);
+        unsigned matches = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+        count += store_matches(keys + i, matches, out + count);
+    }
+    return count + prefix_eq_scalar(keys + i, size - i, prefix, mask, out + count);
+}
+
+#endif
+
+constexpr FilterKernels SCALAR_KERNELS{"scalar", any_byte_eq_scalar, prefix_eq_scalar};
+#ifdef IP_FILTER_X86
+constexpr FilterKernels SSE2_KERNELS{"sse2", any_byte_eq_sse2, prefix_eq_sse2};
+constexpr FilterKernels AVX2_KERNELS{"avx2", any_byte_eq_avx2, prefix_eq_avx2};
+#endif
+
+}  // namespace
+
+SimdLevel detect_simd_level() noexcept {
+#ifdef IP_FILTER_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+const FilterKernels& filter_kernels(SimdLevel level) noexcept {
+    switch (level) {
+#ifdef IP_FILTER_X86
+        case SimdLevel::AVX2:
+            return AVX2_KERNELS;
+        case SimdLevel::SSE2:
+            return SSE2_KERNELS;
+#endif
+        default:
+            return SCALAR_KERNELS;
+    }
+}
+
+const FilterKernels& filter_kernels() noexcept {
+    static const FilterKernels& kernels = filter_kernels(detect_simd_level());
+    return kernels;
+}
+
+std::vector<uint32_t> filter_any_byte_eq(std::span<const uint32_t> keys, uint8_t byte) {
+    std::vector<uint32_t> out(keys.size());
+    out.resize(filter_kernels().any_byte_eq(keys.data(), keys.size(), byte, out.data()));
+    return out;
+}
+
+std::vector<uint32_t> filter_prefix_eq(std::span<const uint32_t> keys, uint32_t prefix, uint32_t mask) {
+    std::vector<uint32_t> out(keys.size());
+    out.resize(filter_kernels().prefix_eq(keys.data(), keys.size(), prefix, mask, out.data()));
+    return out;
+}
@@ -2,7 +2,25 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <sstream>
+
 #include "ip_filter.hpp"
+#include "ip_reader.hpp"
+#include "ip_stats.hpp"
+#include "ip_writer.hpp"
+#include "parallel_pipeline.hpp"
+#include "pool_file.hpp"
+#include "prefix_index.hpp"
+#include "radix_sort.hpp"
+#include "simd_filter.hpp"
 
 BOOST_AUTO_TEST_SUITE(test_ips)
 
@@ -12,13 +30,337 @@ BOOST_AUTO_TEST_CASE(mo) {
     BOOST_CHECK(ip_less < ip_greater);
 }
 
+BOOST_AUTO_TEST_CASE(octets) {
+    Ip ip("113.162.145.156");
+    BOOST_CHECK(ip.collapsed_ip_ == 0x71A2919C);
+    BOOST_CHECK(ip.octet(0) == 113);
+    BOOST_CHECK(ip.octet(3) == 156);
+    BOOST_CHECK(ip.str() == "113.162.145.156");
+}
+
 BOOST_AUTO_TEST_CASE(mo1) {
     std::vector<Ip> expected_order{
         {"40.50.22.33"}, {"40.30.11.22"}, {"40.10.22.33"}};  // 51 > 33 > 11
-    std::vector<Ip> ips{{"40.30.11.22"}, {"40.10.22.33"}, {"40.50.22.33"}};
-    lexicographically_sort(ips);
+    std::vector<uint32_t> keys;
+    for (const Ip& ip : std::vector<Ip>{{"40.30.11.22"}, {"40.10.22.33"}, {"40.50.22.33"}}) {
+        keys.push_back(ip.collapsed_ip_);
+    }
+    lexicographically_sort(keys);
+    std::vector<Ip> ips(keys.begin(), keys.end());
     BOOST_CHECK_EQUAL_COLLECTIONS(ips.begin(), ips.end(), expected_order.begin(),
                                   expected_order.end());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_reader)
+
+BOOST_AUTO_TEST_CASE(parse) {
+    const std::string line = "113.162.145.156\t111\t0";
+    uint32_t collapsed_ip = 0;
+    const char* stop = parse_ip(line.data(), line.data() + line.size(), collapsed_ip);
+    BOOST_REQUIRE(stop != nullptr);
+    BOOST_CHECK(*stop == '\t');
+    BOOST_CHECK(Ip(collapsed_ip) == Ip("113.162.145.156"));
+
+    for (const std::string bad : {"1.2.3", "256.1.1.1", "1..2.3", "a.b.c.d", ""}) {
+        BOOST_CHECK(parse_ip(bad.data(), bad.data() + bad.size(), collapsed_ip) == nullptr);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stream_chunks) {
+    std::istringstream input("1.2.3.4\t5\t6\n10.20.30.40\t1\t1\r\n\n255.255.255.255");
+    // tiny chunk forces lines to be split across reads
+    auto keys = read_from_stream(input, 4);
+    std::vector<uint32_t> expected{Ip("1.2.3.4").collapsed_ip_, Ip("10.20.30.40").collapsed_ip_, Ip("255.255.255.255").collapsed_ip_};
+    BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+
+    std::istringstream bad_input("1.2.3.4\n1.2.3.4567\t1\n");
+    BOOST_CHECK_THROW(read_from_stream(bad_input), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_sort)
+
+BOOST_AUTO_TEST_CASE(radix_matches_std_sort) {
+    std::mt19937 gen(7);
+    for (size_t size : {0, 1, 100, 5000}) {
+        std::vector<uint32_t> keys(size);
+        std::generate(keys.begin(), keys.end(), gen);
+        // half of the keys with zero high bytes, every digit still varies
+        for (size_t i = 0; i < size; i += 2) {
+            keys[i] &= 0x0000FFFF;
+        }
+        auto expected = keys;
+        std::sort(expected.begin(), expected.end(), std::greater<uint32_t>());
+        radix_sort_desc(keys);
+        BOOST_CHECK(keys == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(radix_skips_constant_digits) {
+    std::mt19937 gen(5);
+    // two skipped passes leave the result in place, one skipped pass in the buffer, all equal skips every pass
+    for (uint32_t mask : {0x0000FFFFu, 0x00FFFFFFu, 0xFF00FF00u, 0u}) {
+        std::vector<uint32_t> keys(5000);
+        std::generate(keys.begin(), keys.end(), [&gen, mask] { return (gen() & mask) | 0x46000000u; });
+        auto expected = keys;
+        std::sort(expected.begin(), expected.end(), std::greater<uint32_t>());
+        radix_sort_desc(keys);
+        BOOST_CHECK(keys == expected);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_parallel)
+
+BOOST_AUTO_TEST_CASE(line_aligned_chunks) {
+    const std::string log = "1.1.1.1\t1\n2.2.2.2\t1\n3.3.3.3\t1\n4.4.4.4";
+    auto chunks = split_line_aligned(log.data(), log.data() + log.size(), 3);
+    BOOST_REQUIRE(!chunks.empty());
+    BOOST_CHECK(chunks.front().first == log.data());
+    BOOST_CHECK(chunks.back().second == log.data() + log.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (i + 1 < chunks.size()) {
+            BOOST_CHECK(chunks[i].second[-1] == '\n');
+            BOOST_CHECK(chunks[i].second == chunks[i + 1].first);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matches_sequential) {
+    std::mt19937 gen(11);
+    std::string log;
+    std::vector<uint32_t> keys;
+    for (int i = 0; i < 3000; i++) {
+        // narrow first octet so all filters have matches
+        uint32_t key = (static_cast<uint32_t>(gen() % 3 == 0 ? 46 : 1) << 24) | (gen() & 0x00FFFFFF);
+        if (i % 10 == 0) {
+            key = (key & 0xFF00FFFF) | (70u << 16);
+        }
+        keys.push_back(key);
+        log += Ip(key).str() + "\t1\t1\n";
+    }
+    radix_sort_desc(keys);
+
+    PipelineResult result = run_parallel_pipeline(log.data(), log.data() + log.size(), 4);
+    BOOST_CHECK(result.sorted == keys);
+
+    std::vector<uint32_t> first_is_1;
+    std::vector<uint32_t> first_46_second_70;
+    std::vector<uint32_t> any_is_46;
+    for (uint32_t key : keys) {
+        Ip ip(key);
+        if (ip.octet(0) == 1) {
+            first_is_1.push_back(key);
+        }
+        if (ip.octet(0) == 46 && ip.octet(1) == 70) {
+            first_46_second_70.push_back(key);
+        }
+        auto octets = ip.octets();
+        if (std::find(octets.begin(), octets.end(), 46) != octets.end()) {
+            any_is_46.push_back(key);
+        }
+    }
+    BOOST_CHECK(result.first_is_1 == first_is_1);
+    BOOST_CHECK(!first_46_second_70.empty());
+    BOOST_CHECK(result.first_46_second_70 == first_46_second_70);
+    BOOST_CHECK(result.any_is_46 == any_is_46);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_simd)
+
+BOOST_AUTO_TEST_CASE(kernels_match_scalar) {
+    std::mt19937 gen(3);
+    // odd size leaves a tail for the scalar loop
+    std::vector<uint32_t> keys(1003);
+    for (auto& key : keys) {
+        key = gen();
+        if (gen() % 4 == 0) {
+            key = (key & 0x0000FFFF) | 0x2E460000;
+        }
+    }
+
+    const auto& scalar = filter_kernels(SimdLevel::SCALAR);
+    std::vector<uint32_t> expected(keys.size());
+    expected.resize(scalar.any_byte_eq(keys.data(), keys.size(), 46, expected.data()));
+    for (uint32_t key : expected) {
+        Ip ip(key);
+        auto octets = ip.octets();
+        BOOST_CHECK(std::find(octets.begin(), octets.end(), 46) != octets.end());
+    }
+
+    std::vector<uint32_t> expected_prefix(keys.size());
+    expected_prefix.resize(scalar.prefix_eq(keys.data(), keys.size(), 0x2E460000, 0xFFFF0000, expected_prefix.data()));
+    BOOST_CHECK(!expected_prefix.empty());
+
+    for (auto level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+        if (level > detect_simd_level()) {
+            continue;
+        }
+        const auto& kernels = filter_kernels(level);
+        std::vector<uint32_t> out(keys.size());
+        out.resize(kernels.any_byte_eq(keys.data(), keys.size(), 46, out.data()));
+        BOOST_CHECK(out == expected);
+
+        out.assign(keys.size(), 0);
+        out.resize(kernels.prefix_eq(keys.data(), keys.size(), 0x2E460000, 0xFFFF0000, out.data()));
+        BOOST_CHECK(out == expected_prefix);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_index)
+
+BOOST_AUTO_TEST_CASE(matches_linear_scan) {
+    std::mt19937 gen(5);
+    std::vector<uint32_t> keys(20000);
+    for (auto& key : keys) {
+        // cluster keys to get many equal prefixes and duplicates
+        key = (static_cast<uint32_t>(gen() % 64) << 24) | (gen() & 0x03FF03FF);
+    }
+    keys.push_back(0);
+    keys.push_back(0xFFFFFFFF);
+    radix_sort_desc(keys);
+    PrefixIndex index(keys);
+
+    auto scan = [&keys](uint32_t low, uint32_t high) {
+        std::vector<uint32_t> out;
+        std::copy_if(keys.begin(), keys.end(), std::back_inserter(out), [=](uint32_t key) { return key >= low && key <= high; });
+        return out;
+    };
+    auto as_vector = [](std::span<const uint32_t> span) { return std::vector<uint32_t>(span.begin(), span.end()); };
+
+    BOOST_CHECK(as_vector(index.prefix(1)) == scan(0x01000000, 0x01FFFFFF));
+    BOOST_CHECK(as_vector(index.prefix(255)) == scan(0xFF000000, 0xFFFFFFFF));
+    BOOST_CHECK(as_vector(index.prefix(46, 2)) == scan(0x2E020000, 0x2E02FFFF));
+    BOOST_CHECK(as_vector(index.cidr(parse_cidr("0.0.0.0/0"))) == keys);
+    BOOST_CHECK(as_vector(index.cidr(parse_cidr("10.0.0.0/7"))) == scan(0x0A000000, 0x0BFFFFFF));
+    BOOST_CHECK(as_vector(index.cidr(parse_cidr("20.1.2.0/23"))) == scan(0x14010200, 0x140103FF));
+    BOOST_CHECK(as_vector(index.cidr(parse_cidr(Ip(keys[100]).str()))) == scan(keys[100], keys[100]));
+}
+
+BOOST_AUTO_TEST_CASE(bad_cidr) {
+    for (const std::string bad : {"1.2.3.4/33", "1.2.3.4/", "1.2.3/8", "1.2.3.4/8x"}) {
+        BOOST_CHECK_THROW(parse_cidr(bad), std::runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_pool_file)
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+    const auto path = (std::filesystem::temp_directory_path() / "test_filter_pool.bin").string();
+    std::vector<uint32_t> keys{0x2E460101, 0x2E46FF00, 0x01020304, 0xC0A80001, 0x2E000000};
+    radix_sort_desc(keys);
+    write_pool_file(path, keys, PrefixIndex(keys));
+
+    {
+        PoolFile pool(path);
+        BOOST_CHECK(std::vector<uint32_t>(pool.keys().begin(), pool.keys().end()) == keys);
+        BOOST_CHECK(pool.index().prefix(46, 70).size() == 2);
+        BOOST_CHECK(pool.index().prefix(1).size() == 1);
+        BOOST_CHECK(pool.index().cidr(parse_cidr("46.0.0.0/8")).size() == 3);
+    }
+
+    // count whose byte size wraps around to the real one is rejected
+    auto patch = [&path](std::streamoff offset, uint64_t value) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    patch(offsetof(PoolHeader, count), keys.size() + (uint64_t{1} << 62));
+    BOOST_CHECK_THROW(PoolFile{path}, std::runtime_error);
+    patch(offsetof(PoolHeader, count), keys.size());
+
+    // prefix counts are subspan bounds, a growing one is rejected
+    patch(sizeof(PoolHeader) + 100 * sizeof(uint64_t), keys.size() + 10);
+    BOOST_CHECK_THROW(PoolFile{path}, std::runtime_error);
+    write_pool_file(path, keys, PrefixIndex(keys));
+
+    // truncated file is rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    BOOST_CHECK_THROW(PoolFile{path}, std::runtime_error);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "1.2.3.4\t1\t1\n";
+    BOOST_CHECK_THROW(PoolFile{path}, std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_stats)
+
+BOOST_AUTO_TEST_CASE(distinct_and_top) {
+    std::mt19937 gen(9);
+    IpStats stats(3, true);
+    IpStats top_only(3, false);
+    std::vector<uint32_t> seen;
+    // three heavy keys among a lot of unique noise
+    for (int i = 0; i < 20000; i++) {
+        uint32_t key = gen();
+        if (i % 10 == 0) {
+            key = 0x01010101;
+        } else if (i % 10 == 1) {
+            key = 0x2E460000;
+        } else if (i % 20 == 2) {
+            key = 0xC0A80001;
+        }
+        stats.add(key);
+        top_only.add(key);
+        seen.push_back(key);
+    }
+    std::sort(seen.begin(), seen.end());
+    const auto unique = static_cast<size_t>(std::unique(seen.begin(), seen.end()) - seen.begin());
+
+    BOOST_CHECK(stats.total() == 20000);
+    BOOST_CHECK(stats.distinct() == unique);
+    BOOST_CHECK(top_only.distinct() == 0);
+    BOOST_CHECK(top_only.top().front().key == stats.top().front().key);
+
+    auto top = stats.top();
+    BOOST_REQUIRE(top.size() == 3);
+    BOOST_CHECK(top[0].key == 0x2E460000 || top[0].key == 0x01010101);
+    BOOST_CHECK(top[2].key == 0xC0A80001);
+    for (const auto& heavy_hitter : top) {
+        BOOST_CHECK(heavy_hitter.count - heavy_hitter.error <= 2000);
+        BOOST_CHECK(heavy_hitter.count >= 1000);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_writer)
+
+BOOST_AUTO_TEST_CASE(format) {
+    char text[MAX_IP_TEXT];
+    for (const std::string ip : {"0.0.0.0", "255.255.255.255", "10.9.100.99", "1.22.233.4"}) {
+        BOOST_CHECK(std::string(text, format_ip(Ip(ip).collapsed_ip_, text)) == ip);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(buffered_output) {
+    std::FILE* file = std::tmpfile();
+    BOOST_REQUIRE(file);
+    {
+        // small buffer forces several flushes
+        IpWriter out(fileno(file), 20);
+        out.write_ips(std::vector<uint32_t>{0x01020304, 0xFFFFFFFF, 0x2E460000});
+        out.write_ip(0x0A000001, '\t');
+        out.write("some text longer than the whole buffer\n");
+    }
+    std::rewind(file);
+    std::string written(256, '\0');
+    written.resize(std::fread(written.data(), 1, written.size(), file));
+    std::fclose(file);
+    BOOST_CHECK(written == "1.2.3.4\n255.255.255.255\n46.70.0.0\n10.0.0.1\tsome text longer than the whole buffer\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
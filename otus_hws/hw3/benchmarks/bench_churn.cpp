@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <utility>
+
+#include "better_alloc.hpp"
+#include "pool_resource.hpp"
+
+constexpr size_t CHURN_POOL_SIZE = 64 << 20;
+
+// Map of fixed size where every step erases a random key and inserts another one
+template <typename Map>
+static void map_churn(benchmark::State& state) {
+    const auto size = static_cast<int>(state.range(0));
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> key(0, size * 2);
+
+    Map map;
+    while (static_cast<int>(map.size()) < size) {
+        map.emplace(key(gen), 0);
+    }
+
+    for (auto _ : state) {
+        auto it = map.lower_bound(key(gen));
+        if (it == map.end()) {
+            it = map.begin();
+        }
+        map.erase(it);
+        while (!map.emplace(key(gen), 1).second) {
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+using StdMap = std::map<int, int>;
+using PoolMap = std::map<int, int, std::less<int>, BetterAlloc<std::pair<const int, int>, CHURN_POOL_SIZE>>;
+
+BENCHMARK_TEMPLATE(map_churn, StdMap)->RangeMultiplier(10)->Range(100, 1'000'000);
+BENCHMARK_TEMPLATE(map_churn, PoolMap)->RangeMultiplier(10)->Range(100, 1'000'000);
+
+constexpr size_t ARENA_POOL_SIZE = 4 << 10;
+
+// Per-request map: built from scratch, then thrown away. Pool starts small on purpose,
+// so FIXED pool spills to malloc while CHAINED one keeps bumping from new blobs.
+template <typename Alloc>
+static void map_per_request(benchmark::State& state) {
+    const auto size = static_cast<int>(state.range(0));
+    Alloc alloc;
+    for (auto _ : state) {
+        {
+            std::map<int, int, std::less<int>, Alloc> map(alloc);
+            for (int i = 0; i < size; i++) {
+                map.emplace((i * 7919) % size, i);
+            }
+            benchmark::DoNotOptimize(map.size());
+        }
+        if constexpr (requires { alloc.reset(); }) {
+            alloc.reset();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+using StdNodeAlloc = std::allocator<std::pair<const int, int>>;
+using FixedNodeAlloc = BetterAlloc<std::pair<const int, int>, ARENA_POOL_SIZE>;
+using ArenaNodeAlloc = ArenaAlloc<std::pair<const int, int>, ARENA_POOL_SIZE>;
+
+BENCHMARK_TEMPLATE(map_per_request, StdNodeAlloc)->RangeMultiplier(10)->Range(100, 100'000);
+BENCHMARK_TEMPLATE(map_per_request, FixedNodeAlloc)->RangeMultiplier(10)->Range(100, 100'000);
+BENCHMARK_TEMPLATE(map_per_request, ArenaNodeAlloc)->RangeMultiplier(10)->Range(100, 100'000);
+
+// Same per-request map through std::pmr, resource is released after every request
+template <typename Resource>
+static void pmr_map_per_request(benchmark::State& state) {
+    const auto size = static_cast<int>(state.range(0));
+    Resource resource;
+    for (auto _ : state) {
+        {
+            std::pmr::map<int, int> map(&resource);
+            for (int i = 0; i < size; i++) {
+                map.emplace((i * 7919) % size, i);
+            }
+            benchmark::DoNotOptimize(map.size());
+        }
+        resource.release();
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+struct PooledResource : PoolResource {
+    PooledResource() : PoolResource(ARENA_POOL_SIZE, ResourceKind::POOLED) {
+    }
+};
+
+struct MonotonicResource : PoolResource {
+    MonotonicResource() : PoolResource(ARENA_POOL_SIZE, ResourceKind::MONOTONIC) {
+    }
+};
+
+BENCHMARK_TEMPLATE(pmr_map_per_request, std::pmr::unsynchronized_pool_resource)->RangeMultiplier(10)->Range(100, 100'000);
+BENCHMARK_TEMPLATE(pmr_map_per_request, std::pmr::monotonic_buffer_resource)->RangeMultiplier(10)->Range(100, 100'000);
+BENCHMARK_TEMPLATE(pmr_map_per_request, PooledResource)->RangeMultiplier(10)->Range(100, 100'000);
+BENCHMARK_TEMPLATE(pmr_map_per_request, MonotonicResource)->RangeMultiplier(10)->Range(100, 100'000);
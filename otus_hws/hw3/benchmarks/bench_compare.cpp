@@ -0,0 +1,340 @@
+// Containers x allocators x workloads. Besides time every run reports
+//   time_per_op - time of one container operation (shown as 12.3n for 12.3 ns)
+//   page_faults - minor + major faults per iteration
+//   rss_kb      - resident memory taken by one container of the run size, measured
+//                 with a fresh allocator after freed heap is given back to the OS
+// Sizes go from 10 up to ALLOC_BENCH_MAX_SIZE (1M by default, 10M at most).
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "better_alloc.hpp"
+#include "not_even_vector.hpp"
+#include "pool_resource.hpp"
+
+namespace {
+
+constexpr size_t POOL_SIZE = 64 << 20;
+constexpr size_t ARENA_BLOCK = 64 << 10;
+
+std::vector<int64_t> bench_container_sizes() {
+    size_t max_size = 1'000'000;
+    if (const char* env = std::getenv("ALLOC_BENCH_MAX_SIZE")) {
+        max_size = std::strtoull(env, nullptr, 10);
+    }
+    std::vector<int64_t> sizes;
+    for (size_t size = 10; size <= 10'000'000 && size <= max_size; size *= 10) {
+        sizes.push_back(static_cast<int64_t>(size));
+    }
+    return sizes;
+}
+
+size_t page_faults() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_minflt + usage.ru_majflt);
+}
+
+size_t resident_kb() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(::sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+// Allocator policies: allocator<T> type plus the state all containers of a run share
+
+struct StdPolicy {
+    static constexpr const char* NAME = "std";
+    template <typename T>
+    using allocator = std::allocator<T>;
+
+    template <typename T>
+    allocator<T> get() {
+        return {};
+    }
+    void after_round() {
+    }
+};
+
+struct PoolPolicy {
+    static constexpr const char* NAME = "better_alloc";
+    template <typename T>
+    using allocator = BetterAlloc<T, POOL_SIZE>;
+
+    template <typename T>
+    allocator<T> get() {
+        return allocator<T>(base);
+    }
+    void after_round() {
+    }
+
+    allocator<std::byte> base;
+};
+
+struct PmrPolicy {
+    static constexpr const char* NAME = "pmr_pool";
+    template <typename T>
+    using allocator = std::pmr::polymorphic_allocator<T>;
+
+    template <typename T>
+    allocator<T> get() {
+        return allocator<T>(&resource);
+    }
+    void after_round() {
+    }
+
+    PoolResource resource{ARENA_BLOCK, ResourceKind::POOLED};
+};
+
+struct ArenaPolicy {
+    static constexpr const char* NAME = "arena";
+    template <typename T>
+    using allocator = ArenaAlloc<T, ARENA_BLOCK>;
+
+    template <typename T>
+    allocator<T> get() {
+        return allocator<T>(base);
+    }
+    // nothing is alive between rounds of insert workload
+    void after_round() {
+        base.reset();
+    }
+
+    allocator<std::byte> base;
+};
+
+// Containers: type for a policy, construction and the three operations of workloads
+
+struct MapFamily {
+    static constexpr const char* NAME = "map";
+    template <typename P>
+    using type = std::map<int, int, std::less<int>, typename P::template allocator<std::pair<const int, int>>>;
+
+    template <typename P>
+    static type<P> make(P& policy) {
+        return type<P>(policy.template get<std::pair<const int, int>>());
+    }
+    template <typename C>
+    static void add(C& c, int key) {
+        c.emplace(key, key);
+    }
+    template <typename C>
+    static void churn(C& c, int key) {
+        c.erase(key);
+        c.emplace(key, key);
+    }
+};
+
+struct UnorderedMapFamily {
+    static constexpr const char* NAME = "unordered_map";
+    template <typename P>
+    using type = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                                    typename P::template allocator<std::pair<const int, int>>>;
+
+    template <typename P>
+    static type<P> make(P& policy) {
+        return type<P>(policy.template get<std::pair<const int, int>>());
+    }
+    template <typename C>
+    static void add(C& c, int key) {
+        c.emplace(key, key);
+    }
+    template <typename C>
+    static void churn(C& c, int key) {
+        c.erase(key);
+        c.emplace(key, key);
+    }
+};
+
+struct ListFamily {
+    static constexpr const char* NAME = "list";
+    template <typename P>
+    using type = std::list<int, typename P::template allocator<int>>;
+
+    template <typename P>
+    static type<P> make(P& policy) {
+        return type<P>(policy.template get<int>());
+    }
+    template <typename C>
+    static void add(C& c, int key) {
+        c.push_back(key);
+    }
+    template <typename C>
+    static void churn(C& c, int key) {
+        c.pop_front();
+        c.push_back(key);
+    }
+};
+
+struct VectorFamily {
+    static constexpr const char* NAME = "another_vector";
+    template <typename P>
+    using type = AnotherVector<int, typename P::template allocator<int>>;
+
+    template <typename P>
+    static type<P> make(P& policy) {
+        return type<P>(0, policy.template get<int>());
+    }
+    template <typename C>
+    static void add(C& c, int key) {
+        c.push_back(key);
+    }
+    template <typename C>
+    static void churn(C& c, int key) {
+        c.pop_back();
+        c.push_back(key);
+    }
+};
+
+// keys in [0, size) in random order, same for every run
+const std::vector<int>& shuffled_keys(size_t size) {
+    static std::map<size_t, std::vector<int>> cache;
+    auto& keys = cache[size];
+    if (keys.empty()) {
+        keys.resize(size);
+        for (size_t i = 0; i < size; i++) {
+            keys[i] = static_cast<int>(i);
+        }
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    }
+    return keys;
+}
+
+template <typename Family, typename P>
+void fill(typename Family::template type<P>& container, const std::vector<int>& keys) {
+    for (int key : keys) {
+        Family::add(container, key);
+    }
+}
+
+template <typename Family, typename P>
+size_t container_rss_kb(const std::vector<int>& keys) {
+    ::malloc_trim(0);
+    const size_t before = resident_kb();
+    P policy;
+    auto container = Family::make(policy);
+    fill<Family, P>(container, keys);
+    const size_t after = resident_kb();
+    return after > before ? after - before : 0;
+}
+
+void report(benchmark::State& state, size_t ops_per_iteration, size_t faults_before) {
+    const auto ops = static_cast<double>(ops_per_iteration);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ops_per_iteration));
+    state.counters["time_per_op"] =
+        benchmark::Counter(ops, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["page_faults"] =
+        benchmark::Counter(static_cast<double>(page_faults() - faults_before), benchmark::Counter::kAvgIterations);
+}
+
+// whole container built from scratch and destroyed every iteration
+template <typename Family, typename P>
+void insert_heavy(benchmark::State& state) {
+    const auto& keys = shuffled_keys(static_cast<size_t>(state.range(0)));
+    P policy;
+    const size_t faults = page_faults();
+    for (auto _ : state) {
+        {
+            auto container = Family::make(policy);
+            fill<Family, P>(container, keys);
+            benchmark::DoNotOptimize(&container);
+        }
+        policy.after_round();
+    }
+    report(state, keys.size(), faults);
+    state.counters["rss_kb"] = static_cast<double>(container_rss_kb<Family, P>(keys));
+}
+
+// container of fixed size, every op removes one element and adds another
+template <typename Family, typename P>
+void churn_heavy(benchmark::State& state) {
+    const auto& keys = shuffled_keys(static_cast<size_t>(state.range(0)));
+    P policy;
+    auto container = Family::make(policy);
+    fill<Family, P>(container, keys);
+
+    constexpr size_t OPS = 1024;
+    size_t next = 0;
+    const size_t faults = page_faults();
+    for (auto _ : state) {
+        for (size_t i = 0; i < OPS; i++) {
+            Family::churn(container, keys[next]);
+            next = next + 1 == keys.size() ? 0 : next + 1;
+        }
+        benchmark::DoNotOptimize(&container);
+    }
+    report(state, OPS, faults);
+}
+
+// full scan, node placement decides the cache behaviour
+template <typename Family, typename P>
+void iterate_heavy(benchmark::State& state) {
+    const auto& keys = shuffled_keys(static_cast<size_t>(state.range(0)));
+    P policy;
+    auto container = Family::make(policy);
+    fill<Family, P>(container, keys);
+
+    const size_t faults = page_faults();
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (const auto& item : container) {
+            if constexpr (requires { item.second; }) {
+                sum += item.second;
+            } else {
+                sum += item;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    report(state, keys.size(), faults);
+}
+
+template <typename Family, typename P>
+void register_family_policy() {
+    const std::string suffix = std::string(Family::NAME) + "/" + P::NAME;
+    for (auto* bench : {
+             benchmark::RegisterBenchmark(("insert/" + suffix).c_str(), insert_heavy<Family, P>),
+             benchmark::RegisterBenchmark(("churn/" + suffix).c_str(), churn_heavy<Family, P>),
+             benchmark::RegisterBenchmark(("iterate/" + suffix).c_str(), iterate_heavy<Family, P>),
+         }) {
+        for (int64_t size : bench_container_sizes()) {
+            bench->Arg(size);
+        }
+    }
+}
+
+template <typename Family>
+void register_family() {
+    register_family_policy<Family, StdPolicy>();
+    register_family_policy<Family, PoolPolicy>();
+    register_family_policy<Family, PmrPolicy>();
+    register_family_policy<Family, ArenaPolicy>();
+}
+
+const bool registered = [] {
+    register_family<MapFamily>();
+    register_family<UnorderedMapFamily>();
+    register_family<ListFamily>();
+    register_family<VectorFamily>();
+    return true;
+}();
+
+}  // namespace
@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "better_alloc.hpp"
+
+constexpr size_t THREADS_POOL_SIZE = 256 << 20;
+constexpr int NODES_PER_ROUND = 256;
+
+// Every thread builds and clears its own map, all maps use copies of one allocator
+template <typename Alloc>
+static void threads_map_rounds(benchmark::State& state) {
+    static Alloc* shared = nullptr;
+    if (state.thread_index() == 0) {
+        shared = new Alloc();
+    }
+    // threads wait for each other before the first iteration
+    for (auto _ : state) {
+        std::map<int, int, std::less<int>, Alloc> map(*shared);
+        for (int i = 0; i < NODES_PER_ROUND; i++) {
+            map.emplace((i * 7919) % NODES_PER_ROUND, i);
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * NODES_PER_ROUND);
+    if (state.thread_index() == 0) {
+        // loop ends with a barrier too, nobody uses the allocator anymore
+        delete shared;
+        shared = nullptr;
+    }
+}
+
+using NodeValue = std::pair<const int, int>;
+using StdAlloc = std::allocator<NodeValue>;
+using CacheAlloc = SharedAlloc<NodeValue, THREADS_POOL_SIZE>;
+using ArenaPerThreadAlloc = ThreadArenaAlloc<NodeValue, 64 << 10>;
+
+BENCHMARK_TEMPLATE(threads_map_rounds, StdAlloc)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(threads_map_rounds, CacheAlloc)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(threads_map_rounds, ArenaPerThreadAlloc)->ThreadRange(1, 64)->UseRealTime();
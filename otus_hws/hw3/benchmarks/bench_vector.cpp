@@ -0,0 +1,133 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "better_alloc.hpp"
+#include "not_even_vector.hpp"
+#include "small_vector.hpp"
+
+// Many short vectors: the typical case is fewer than 8 elements
+template <typename Vector>
+static void short_vectors(benchmark::State& state) {
+    const auto length = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        Vector v;
+        for (int i = 0; i < length; i++) {
+            v.push_back(i);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * length);
+}
+
+BENCHMARK_TEMPLATE(short_vectors, std::vector<int>)->DenseRange(2, 8, 2)->Arg(32);
+BENCHMARK_TEMPLATE(short_vectors, AnotherVector<int>)->DenseRange(2, 8, 2)->Arg(32);
+BENCHMARK_TEMPLATE(short_vectors, AnotherSmallVector<int, 8>)->DenseRange(2, 8, 2)->Arg(32);
+
+// Growth from empty: every doubling moves the whole buffer
+template <typename Vector>
+static void push_back_growth(benchmark::State& state) {
+    const auto length = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        Vector v;
+        for (int i = 0; i < length; i++) {
+            v.push_back(typename Vector::value_type{});
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * length);
+}
+
+// every iteration creates its own 1 MiB pool, it shows on the small sizes
+using IntPoolVector = AnotherVector<int, BetterAlloc<int, 1 << 20>>;
+
+BENCHMARK_TEMPLATE(push_back_growth, std::vector<int>)->RangeMultiplier(10)->Range(100, 1'000'000);
+BENCHMARK_TEMPLATE(push_back_growth, AnotherVector<int>)->RangeMultiplier(10)->Range(100, 1'000'000);
+BENCHMARK_TEMPLATE(push_back_growth, IntPoolVector)->RangeMultiplier(10)->Range(100, 1'000'000);
+BENCHMARK_TEMPLATE(push_back_growth, std::vector<std::string>)->RangeMultiplier(10)->Range(100, 100'000);
+BENCHMARK_TEMPLATE(push_back_growth, AnotherVector<std::string>)->RangeMultiplier(10)->Range(100, 100'000);
+
+template <typename Vector>
+static Vector random_ints(size_t count) {
+    std::mt19937 gen(42);
+    Vector v;
+    v.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        v.push_back(static_cast<int>(gen()));
+    }
+    return v;
+}
+
+template <typename Vector>
+static void ranges_sort(benchmark::State& state) {
+    const auto source = random_ints<std::vector<int>>(static_cast<size_t>(state.range(0)));
+    Vector v;
+    v.reserve(source.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        v.clear();
+        for (int value : source) {
+            v.push_back(value);
+        }
+        state.ResumeTiming();
+        std::ranges::sort(v);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// std::copy to plain array: lowers to memmove only for contiguous iterators
+template <typename Vector>
+static void copy_out(benchmark::State& state) {
+    const auto v = random_ints<Vector>(static_cast<size_t>(state.range(0)));
+    std::vector<int> out(v.size());
+    for (auto _ : state) {
+        std::copy(v.begin(), v.end(), out.begin());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<int64_t>(sizeof(int)));
+}
+
+template <typename Vector>
+static void find_missing(benchmark::State& state) {
+    auto v = random_ints<Vector>(static_cast<size_t>(state.range(0)));
+    for (auto& value : v) {
+        value |= 1;
+    }
+    for (auto _ : state) {
+        // even value is never there, whole vector is scanned
+        benchmark::DoNotOptimize(std::ranges::find(v, 2));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(ranges_sort, std::vector<int>)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+BENCHMARK_TEMPLATE(ranges_sort, AnotherVector<int>)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+BENCHMARK_TEMPLATE(copy_out, std::vector<int>)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+BENCHMARK_TEMPLATE(copy_out, AnotherVector<int>)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+BENCHMARK_TEMPLATE(find_missing, std::vector<int>)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+BENCHMARK_TEMPLATE(find_missing, AnotherVector<int>)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+
+// Loading a dataset: element by element vs one append_range
+template <bool Bulk>
+static void load_ints(benchmark::State& state) {
+    const auto source = random_ints<std::vector<int>>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        AnotherVector<int> v;
+        if constexpr (Bulk) {
+            v.append_range(source);
+        } else {
+            for (int value : source) {
+                v.push_back(value);
+            }
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(load_ints, false)->RangeMultiplier(10)->Range(1'000, 1'000'000);
+BENCHMARK_TEMPLATE(load_ints, true)->RangeMultiplier(10)->Range(1'000, 1'000'000);
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+// Configured by WITH_ALLOC_STATS cmake option. When off, BetterAlloc keeps no
+// counters at all and its hot path is the same as without this header.
+#ifdef BETTER_ALLOC_STATS
+inline constexpr bool ALLOC_STATS_ENABLED = true;
+#else
+inline constexpr bool ALLOC_STATS_ENABLED = false;
+#endif
+
+struct AllocStats {
+    size_t pool_hits = 0;
+    size_t fallback_mallocs = 0;
+    size_t deallocations = 0;
+    // resizes of a block, one each whether it was kept in place or moved
+    size_t reallocations = 0;
+    // bytes requested by containers, pool and fallback together
+    size_t bytes_in_use = 0;
+    size_t high_water = 0;
+    size_t pool_bytes_in_use = 0;
+    // bytes of the pool ever handed out, filled by the allocator
+    size_t pool_bytes_touched = 0;
+
+    // Share of touched pool memory that isn't in use right now: blocks sitting
+    // in free lists, size class rounding and dropped tails of chained blobs
+    double fragmentation() const noexcept {
+        if (pool_bytes_touched == 0) {
+            return 0.0;
+        }
+        return 1.0 - static_cast<double>(pool_bytes_in_use) / static_cast<double>(pool_bytes_touched);
+    }
+};
+
+enum class AllocEventKind { POOL_ALLOCATE, FALLBACK_ALLOCATE, POOL_DEALLOCATE, FALLBACK_DEALLOCATE, REALLOCATE };
+
+struct AllocEvent {
+    AllocEventKind kind;
+    const void* ptr;
+    size_t bytes;
+};
+
+// Counters shared by all copies of one allocator. Relaxed atomics: thread safe
+// pools update them from many threads, totals only have to be eventually right.
+class AllocCounters {
+public:
+    using Trace = std::function<void(const AllocEvent&)>;
+
+    void on_allocate(const void* ptr, size_t bytes, bool from_pool) noexcept {
+        (from_pool ? pool_hits_ : fallback_mallocs_).fetch_add(1, std::memory_order_relaxed);
+        if (from_pool) {
+            pool_bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        raise_high_water(bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        notify({from_pool ? AllocEventKind::POOL_ALLOCATE : AllocEventKind::FALLBACK_ALLOCATE, ptr, bytes});
+    }
+
+    void on_deallocate(const void* ptr, size_t bytes, bool from_pool) noexcept {
+        deallocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+        if (from_pool) {
+            pool_bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+        notify({from_pool ? AllocEventKind::POOL_DEALLOCATE : AllocEventKind::FALLBACK_DEALLOCATE, ptr, bytes});
+    }
+
+    // old_bytes block became ptr of bytes, possibly moved between pool and malloc
+    void on_reallocate(size_t old_bytes, bool old_from_pool, const void* ptr, size_t bytes, bool from_pool) noexcept {
+        reallocations_.fetch_add(1, std::memory_order_relaxed);
+        if (old_from_pool) {
+            pool_bytes_in_use_.fetch_sub(old_bytes, std::memory_order_relaxed);
+        }
+        if (from_pool) {
+            pool_bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        // unsigned wrap makes a shrink a subtraction
+        raise_high_water(bytes_in_use_.fetch_add(bytes - old_bytes, std::memory_order_relaxed) + bytes - old_bytes);
+        notify({AllocEventKind::REALLOCATE, ptr, bytes});
+    }
+
+    // bytes in use drop to zero, high water mark is kept
+    void on_reset() noexcept {
+        bytes_in_use_.store(0, std::memory_order_relaxed);
+        pool_bytes_in_use_.store(0, std::memory_order_relaxed);
+    }
+
+    AllocStats snapshot() const noexcept {
+        AllocStats stats;
+        stats.pool_hits = pool_hits_.load(std::memory_order_relaxed);
+        stats.fallback_mallocs = fallback_mallocs_.load(std::memory_order_relaxed);
+        stats.deallocations = deallocations_.load(std::memory_order_relaxed);
+        stats.reallocations = reallocations_.load(std::memory_order_relaxed);
+        stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+        stats.high_water = high_water_.load(std::memory_order_relaxed);
+        stats.pool_bytes_in_use = pool_bytes_in_use_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Called on every allocate/deallocate/reallocate. Not synchronized with running allocations:
+    // set it before the allocator is used.
+    void set_trace(Trace trace) {
+        trace_ = std::move(trace);
+    }
+
+private:
+    void raise_high_water(size_t in_use) noexcept {
+        size_t high_water = high_water_.load(std::memory_order_relaxed);
+        while (in_use > high_water && !high_water_.compare_exchange_weak(high_water, in_use, std::memory_order_relaxed)) {
+        }
+    }
+
+    void notify(const AllocEvent& event) noexcept {
+        if (trace_) {
+            try {
+                trace_(event);
+            } catch (...) {
+                // tracing must not break allocation
+            }
+        }
+    }
+
+    std::atomic<size_t> pool_hits_{0};
+    std::atomic<size_t> fallback_mallocs_{0};
+    std::atomic<size_t> deallocations_{0};
+    std::atomic<size_t> reallocations_{0};
+    std::atomic<size_t> bytes_in_use_{0};
+    std::atomic<size_t> high_water_{0};
+    std::atomic<size_t> pool_bytes_in_use_{0};
+    Trace trace_;
+};
+
+// Counters of one allocator, copies and rebinds share them
+class SharedAllocStats {
+public:
+    SharedAllocStats() : counters_(std::make_shared<AllocCounters>()) {
+    }
+
+    void on_allocate(const void* ptr, size_t bytes, bool from_pool) noexcept {
+        counters_->on_allocate(ptr, bytes, from_pool);
+    }
+
+    void on_deallocate(const void* ptr, size_t bytes, bool from_pool) noexcept {
+        counters_->on_deallocate(ptr, bytes, from_pool);
+    }
+
+    void on_reallocate(size_t old_bytes, bool old_from_pool, const void* ptr, size_t bytes, bool from_pool) noexcept {
+        counters_->on_reallocate(old_bytes, old_from_pool, ptr, bytes, from_pool);
+    }
+
+    void on_reset() noexcept {
+        counters_->on_reset();
+    }
+
+    AllocStats snapshot() const noexcept {
+        return counters_->snapshot();
+    }
+
+    void set_trace(AllocCounters::Trace trace) {
+        counters_->set_trace(std::move(trace));
+    }
+
+private:
+    std::shared_ptr<AllocCounters> counters_;
+};
+
+// Stands in for the counters when they are off, every update is an empty call
+struct NoAllocStats {
+    void on_allocate(const void*, size_t, bool) noexcept {
+    }
+
+    void on_deallocate(const void*, size_t, bool) noexcept {
+    }
+
+    void on_reallocate(size_t, bool, const void*, size_t, bool) noexcept {
+    }
+
+    void on_reset() noexcept {
+    }
+
+    AllocStats snapshot() const noexcept {
+        return {};
+    }
+
+    void set_trace(const AllocCounters::Trace&) noexcept {
+    }
+};
+
+using AllocStatsHandle = std::conditional_t<ALLOC_STATS_ENABLED, SharedAllocStats, NoAllocStats>;
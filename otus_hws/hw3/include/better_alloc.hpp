@@ -1,12 +1,30 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <format>
 #include <iostream>
-
-template <typename T, size_t N>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "alloc_stats.hpp"
+#include "concurrent_pool.hpp"
+#include "size_class_pool.hpp"
+
+// N - initial pool size in bytes. FIXED pool falls back to malloc when it is full,
+// CHAINED pool grows by chaining blobs, so every allocation stays in the pool.
+// S picks the pool flavour for multithreaded use, see PoolSync.
+template <typename T, size_t N, PoolGrowth G = PoolGrowth::FIXED, PoolSync S = PoolSync::NONE>
 class BetterAlloc {
+    static_assert(S != PoolSync::THREAD_CACHE || G == PoolGrowth::FIXED, "thread caches share one fixed blob");
+    static_assert(S != PoolSync::THREAD_ARENA || G == PoolGrowth::CHAINED, "thread arenas always grow");
+
+    using pool_type = std::conditional_t<S == PoolSync::NONE, SizeClassPool,
+                                         std::conditional_t<S == PoolSync::THREAD_CACHE, ThreadCachePool, ThreadArenaPool>>;
+
 public:
     using value_type = T;
 
@@ -14,53 +32,81 @@ public:
         init(N);
     };
 
-    // required for map/unordered map. This constructor required to construct internal
-    // types of stateless alloc
-    template <typename U, size_t K>
-    BetterAlloc(const BetterAlloc<U, K>&) noexcept {
+    // required for map/unordered map to allocate their nodes. Rebound copy shares
+    // the pool, so a container and its get_allocator() see the same memory
+    template <typename U>
+    BetterAlloc(const BetterAlloc<U, N, G, S>& other) noexcept : pool_(other.pool_), stats_(other.stats_) {
     }
 
     template <typename U>
     struct rebind {
-        using other = BetterAlloc<U, N>;
+        using other = BetterAlloc<U, N, G, S>;
     };
 
+    // memory of one allocator can be freed by another only if they share the pool
+    template <typename U>
+    bool operator==(const BetterAlloc<U, N, G, S>& other) const noexcept {
+        return pool_ == other.pool_;
+    }
+
     // n - amount of object to be placed in this memory blob
     T* allocate(size_t n) {
         size_t bytes_alloc_count = n * TYPE_SIZE;
-        // if pool is full
-        size_t bytes_left = N - pool_offset_b;
-        if (pool_offset_b + bytes_alloc_count > bytes_left) {
-            // std::cout << std::format("Use default alloc to allocate {} bytes ({} objects)\n",
-            //                          n * TYPE_SIZE, n);
-            return static_cast<T*>(std::malloc(bytes_alloc_count));
+        bool from_pool = false;
+        void* ptr = allocate_bytes(bytes_alloc_count, from_pool);
+        if (!ptr) {
+            throw std::bad_alloc();
         }
 
-        char* free_segmet = pool_blob + pool_offset_b;
-
-        T* ptr = static_cast<T*>(static_cast<void*>(free_segmet));  // direct cast char*->T* not allowed
-
-        // std::cout << std::format("Allocated {} bytes ({} objects) at {}\n", n * TYPE_SIZE, n,
-        //                          pool_offset_b);
-
-        pool_offset_b += bytes_alloc_count;
-
-        return ptr;
+        stats_.on_allocate(ptr, bytes_alloc_count, from_pool);
+        return static_cast<T*>(ptr);
     }
 
-    void deallocate(T* ptr, [[maybe_unused]] size_t dealloc_bytes) noexcept {
-        char* chptr = reinterpret_cast<char*>(ptr);
-        bool is_pool_segment = (chptr >= pool_blob) && (chptr < (pool_blob + N));
-        if (is_pool_segment) {
-            // std::cout << std::format("Alloc not so smart to free mem: {} bytes\n",
-            //                          dealloc_bytes * sizeof(T));
-        } else {
-            // std::cout << std::format("Free memory not from pool: {} bytes\n",
-            //                          dealloc_bytes * sizeof(T));
+    void deallocate(T* ptr, size_t n) noexcept {
+        // returned pool blocks go to the free list of their size class
+        // ownership check is a call into the pool, skipped without stats
+        if constexpr (ALLOC_STATS_ENABLED) {
+            if (ptr) {
+                stats_.on_deallocate(ptr, n * TYPE_SIZE, pool_->owns(ptr));
+            }
+        }
+        if (!pool_->deallocate(ptr, n * TYPE_SIZE)) {
             std::free(ptr);
         }
     }
 
+    // Resizes block of old_n objects to new_n keeping its bytes, for trivially copyable T.
+    // Pool block is kept when new size is in the same size class, malloc fallback block
+    // goes through std::realloc, otherwise the bytes move to a new block. Counted as one
+    // reallocation in stats. nullptr if there is no memory for the new size, ptr stays valid then.
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) noexcept {
+        if (!ptr || new_n == 0) {
+            return nullptr;
+        }
+        const size_t old_bytes = old_n * TYPE_SIZE;
+        const size_t new_bytes = new_n * TYPE_SIZE;
+        if (!pool_->owns(ptr)) {
+            void* result = std::realloc(ptr, new_bytes);
+            if (result) {
+                stats_.on_reallocate(old_bytes, false, result, new_bytes, false);
+            }
+            return static_cast<T*>(result);
+        }
+        if (SizeClassPool::size_class(old_bytes) == SizeClassPool::size_class(new_bytes)) {
+            stats_.on_reallocate(old_bytes, true, ptr, new_bytes, true);
+            return ptr;
+        }
+        bool from_pool = false;
+        void* result = allocate_bytes(new_bytes, from_pool);
+        if (!result) {
+            return nullptr;
+        }
+        std::memcpy(result, ptr, std::min(old_bytes, new_bytes));
+        pool_->deallocate(ptr, old_bytes);
+        stats_.on_reallocate(old_bytes, true, result, new_bytes, from_pool);
+        return static_cast<T*>(result);
+    }
+
     template <typename U, typename... Args>
     void construct(U* p, Args&&... args) {
         ::new ((void*) p) U(std::forward<Args>(args)...);
@@ -71,36 +117,87 @@ public:
         p->~U();
     }
 
+    // pool is not the limit: FIXED one falls back to malloc, CHAINED one grows
     constexpr size_t max_size() const noexcept {
-        return N / TYPE_SIZE;
+        return std::numeric_limits<size_t>::max() / TYPE_SIZE;
     }
 
     size_t size() const noexcept {
-        return N - pool_offset_b;
+        return pool_->untouched();
+    }
+
+    size_t capacity() const noexcept {
+        return pool_->capacity();
     }
 
-    ~BetterAlloc() {
-        deinit();
+    // Drops everything allocated so far in one go (per-request arena). Containers using
+    // this allocator must be destroyed or abandoned before, their memory is reused.
+    void reset() noexcept
+        requires(S == PoolSync::NONE)
+    {
+        pool_->reset();
+        stats_.on_reset();
+    }
+
+    // Counters of all copies of this allocator, zeros unless built WITH_ALLOC_STATS
+    AllocStats stats() const noexcept {
+        AllocStats stats = stats_.snapshot();
+        if constexpr (ALLOC_STATS_ENABLED) {
+            if constexpr (S == PoolSync::THREAD_ARENA) {
+                // untouched part of other threads' arenas isn't visible
+                stats.pool_bytes_touched = pool_->capacity();
+            } else {
+                stats.pool_bytes_touched = pool_->capacity() - pool_->untouched();
+            }
+        }
+        return stats;
     }
 
+    // Hook for every allocate/deallocate/reallocate, no-op unless built WITH_ALLOC_STATS
+    void set_trace(AllocCounters::Trace trace) {
+        stats_.set_trace(std::move(trace));
+    }
+
+    ~BetterAlloc() = default;
+
 private:
-    void init(size_t pool_size) {
-        pool_blob = static_cast<char*>(std::malloc(pool_size));
-        if (!pool_blob) {
-            throw std::bad_alloc();
+    template <typename U, size_t K, PoolGrowth H, PoolSync R>
+    friend class BetterAlloc;
+
+    // Pool block or, for FIXED pool, malloc fallback, uncounted. nullptr if neither has room
+    void* allocate_bytes(size_t bytes, bool& from_pool) noexcept {
+        void* ptr = pool_->allocate(bytes);
+        from_pool = ptr != nullptr;
+        if constexpr (G == PoolGrowth::FIXED) {
+            if (!ptr) {
+                ptr = std::malloc(bytes);
+            }
         }
-        // std::cout << std::format("Created pool of {} bytes ({} objects)\n", pool_size,
-        //                          static_cast<size_t>(pool_size / TYPE_SIZE));
-        pool_offset_b = 0;
+        // CHAINED has no malloc fallback: deallocate relies on every block being from the pool
+        return ptr;
     }
 
-    void deinit() {
-        std::free(pool_blob);
-        pool_blob = nullptr;
-        pool_offset_b = 0;
+    void init(size_t pool_size) {
+        // copies share the pool, so memory taken by one copy can be freed by another
+        if constexpr (S == PoolSync::NONE) {
+            pool_ = std::make_shared<SizeClassPool>(pool_size, G);
+        } else {
+            pool_ = std::make_shared<pool_type>(pool_size);
+        }
     }
 
-    char* pool_blob = nullptr;
-    size_t pool_offset_b = 0;  // objects
+    std::shared_ptr<pool_type> pool_;
+    [[no_unique_address]] AllocStatsHandle stats_;
     constexpr static size_t TYPE_SIZE = sizeof(T);
-};
\ No newline at end of file
+};
+
+template <typename T, size_t N>
+using ArenaAlloc = BetterAlloc<T, N, PoolGrowth::CHAINED>;
+
+// Safe to share between threads: N bytes blob with per-thread free lists
+template <typename T, size_t N>
+using SharedAlloc = BetterAlloc<T, N, PoolGrowth::FIXED, PoolSync::THREAD_CACHE>;
+
+// Safe to share between threads: every thread has own arena starting at N bytes
+template <typename T, size_t N>
+using ThreadArenaAlloc = BetterAlloc<T, N, PoolGrowth::CHAINED, PoolSync::THREAD_ARENA>;
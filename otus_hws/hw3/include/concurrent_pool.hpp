@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "size_class_pool.hpp"
+
+enum class PoolSync {
+    NONE,          // single threaded pool
+    THREAD_CACHE,  // one shared blob, every thread keeps own free lists and refills them in batches
+    THREAD_ARENA,  // every thread bumps from its own chained arena
+};
+
+// Per thread storage of pool instances, defined in concurrent_pool.cpp
+template <typename Owner, typename Local>
+class ThreadSlots;
+
+// Fixed blob shared by threads. Allocation and deallocation touch only the
+// calling thread's free lists; a list is refilled (or half of it handed back)
+// BATCH blocks at once from the global depot, fresh blocks are carved from the
+// blob with a CAS on the offset. Must be owned by std::shared_ptr.
+class ThreadCachePool : public std::enable_shared_from_this<ThreadCachePool> {
+public:
+    static constexpr size_t CLASSES = SizeClassPool::CLASSES;
+    static constexpr size_t BATCH = 32;
+    // upper bound for one carve of big blocks
+    static constexpr size_t CARVE_BYTES = 16 << 10;
+
+    explicit ThreadCachePool(size_t capacity);
+    ~ThreadCachePool();
+
+    ThreadCachePool(const ThreadCachePool&) = delete;
+    ThreadCachePool& operator=(const ThreadCachePool&) = delete;
+
+    // nullptr if pool has no room for such block
+    void* allocate(size_t bytes) noexcept;
+    // false if ptr does not belong to the pool
+    bool deallocate(void* ptr, size_t bytes) noexcept;
+
+    bool owns(const void* ptr) const noexcept {
+        const char* p = static_cast<const char*>(ptr);
+        return p >= blob_ && p < blob_ + capacity_;
+    }
+
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    // bytes never carved from the blob yet
+    size_t untouched() const noexcept {
+        return capacity_ - offset_.load(std::memory_order_relaxed);
+    }
+
+private:
+    template <typename Owner, typename Local>
+    friend class ThreadSlots;
+
+    struct FreeNode {
+        FreeNode* next;
+        FreeNode* next_batch;  // valid in the first node of a depot batch
+    };
+
+    struct ThreadCache {
+        std::array<FreeNode*, CLASSES> heads{};
+        std::array<uint32_t, CLASSES> counts{};
+    };
+
+    ThreadCache* local() noexcept;
+    bool refill(ThreadCache& cache, size_t cls) noexcept;
+    void push_batch(size_t cls, FreeNode* head) noexcept;
+    // thread exit: all cached blocks go back to the depot
+    void release(ThreadCache& cache) noexcept;
+
+    const uint64_t id_;
+    char* blob_ = nullptr;
+    size_t capacity_ = 0;
+    std::atomic<size_t> offset_{0};
+
+    std::mutex depot_mutex_;
+    std::array<FreeNode*, CLASSES> depot_{};
+};
+
+// Every thread gets its own CHAINED SizeClassPool, so the hot path has no
+// synchronization at all. Arenas live as long as the pool: arena of an exited
+// thread is handed to the next new thread, and blocks freed by another thread
+// are recycled into that thread's arena. Must be owned by std::shared_ptr.
+class ThreadArenaPool : public std::enable_shared_from_this<ThreadArenaPool> {
+public:
+    explicit ThreadArenaPool(size_t initial_capacity);
+
+    ThreadArenaPool(const ThreadArenaPool&) = delete;
+    ThreadArenaPool& operator=(const ThreadArenaPool&) = delete;
+
+    // nullptr if arena can't grow
+    void* allocate(size_t bytes) noexcept;
+    // every block is from one of the arenas, so it never fails
+    bool deallocate(void* ptr, size_t bytes) noexcept;
+
+    // arenas never fall back to malloc
+    bool owns(const void*) const noexcept {
+        return true;
+    }
+
+    // bytes in arenas of all threads, safe to read while other threads allocate
+    size_t capacity() const noexcept;
+    // bytes of the calling thread's current blob never handed out yet
+    size_t untouched() noexcept;
+
+private:
+    template <typename Owner, typename Local>
+    friend class ThreadSlots;
+
+    SizeClassPool* local() noexcept;
+    // thread exit: arena becomes idle
+    void release(SizeClassPool* arena) noexcept;
+
+    const uint64_t id_;
+    const size_t initial_capacity_;
+
+    // sum of arena capacities, bumped by the owning thread when its arena grows
+    std::atomic<size_t> capacity_{0};
+
+    std::mutex arenas_mutex_;
+    std::vector<std::unique_ptr<SizeClassPool>> arenas_;
+    std::vector<SizeClassPool*> idle_;
+};
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <concepts>
+#include <cstring>
 #include <format>
 #include <iostream>
 #include <memory>
+#include <ranges>
+#include <ratio>
+#include <stdexcept>
 #include <type_traits>
 
 template <typename Alloc, typename T>
@@ -18,7 +23,20 @@ concept AllocatorFor = requires(Alloc a, T* p, size_t n, T&& value) {
     std::allocator_traits<Alloc>::destroy(a, p);
 };
 
-template <typename V, AllocatorFor<V> Alloc = std::allocator<V>>
+// std::ratio bigger than 1, e.g. std::ratio<3, 2>
+template <typename Growth>
+concept GrowthFactor = requires {
+    Growth::num;
+    Growth::den;
+} && (Growth::num > Growth::den) && (Growth::den > 0);
+
+template <GrowthFactor Growth>
+constexpr size_t grow_capacity(size_t capacity) noexcept {
+    // at least one more element: factors like 1.1 don't grow small capacities
+    return std::max(capacity + 1, capacity * Growth::num / Growth::den);
+}
+
+template <typename V, AllocatorFor<V> Alloc = std::allocator<V>, GrowthFactor Growth = std::ratio<2>>
 class AnotherVector {
 public:
     using value_type = V;
@@ -28,89 +46,93 @@ public:
     using ref = V&;
     using cref = const V&;
 
+    // Plain pointer wrapper, std::contiguous_iterator: ranges algorithms, std::copy
+    // and std::span see the underlying array through std::to_address
     template <bool IsConst>
     class AnotherVectorIter {
     public:
-        using diff_type = std::ptrdiff_t;
+        using iterator_concept = std::contiguous_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using diff_type = difference_type;
         using value_type = V;
         using pointer = std::conditional_t<IsConst, const V*, V*>;
         using reference = std::conditional_t<IsConst, const V&, V&>;
-        using iterator_category =
-            std::random_access_iterator_tag;  // used in sort, advance, distance by std algorithms
 
-        AnotherVectorIter() {
-        }
-        explicit AnotherVectorIter(ptr p) : ptr_(p) {
+        AnotherVectorIter() = default;
+
+        explicit AnotherVectorIter(pointer p) noexcept : ptr_(p) {
         }
 
-        template <bool B = IsConst, typename = std::enable_if_t<B>>
-        explicit AnotherVectorIter(const AnotherVectorIter<false>& other) : ptr_(other.ptr_) {
+        // iterator -> const iterator
+        template <bool B = IsConst>
+            requires B
+        AnotherVectorIter(const AnotherVectorIter<false>& other) noexcept : ptr_(other.ptr_) {
         }
 
-        reference operator*() const {
+        reference operator*() const noexcept {
             return *ptr_;
         }
-        pointer operator&() const {
+
+        pointer operator->() const noexcept {
             return ptr_;
         }
 
-        AnotherVectorIter& operator++() {
+        reference operator[](difference_type n) const noexcept {
+            return ptr_[n];
+        }
+
+        AnotherVectorIter& operator++() noexcept {
             ++ptr_;
             return *this;
         }
 
-        AnotherVectorIter& operator--() {
+        AnotherVectorIter& operator--() noexcept {
             --ptr_;
             return *this;
         }
 
-        AnotherVectorIter operator++(int) {
+        AnotherVectorIter operator++(int) noexcept {
             auto obj_ref = *this;
             ++(*this);
             return obj_ref;
         }
 
-        AnotherVectorIter operator--(int) {
+        AnotherVectorIter operator--(int) noexcept {
             auto obj_ref = *this;
             --(*this);
             return obj_ref;
         }
 
-        AnotherVectorIter& operator+(size_t n) const {
-            return AnotherVectorIter(ptr_ + n);
+        AnotherVectorIter& operator+=(difference_type n) noexcept {
+            ptr_ += n;
+            return *this;
         }
 
-        AnotherVectorIter& operator-(size_t n) const {
-            return AnotherVectorIter(ptr_ - n);
+        AnotherVectorIter& operator-=(difference_type n) noexcept {
+            ptr_ -= n;
+            return *this;
         }
 
-        pointer operator[](size_t n) {
-            return *(ptr_ + n);
+        friend AnotherVectorIter operator+(AnotherVectorIter it, difference_type n) noexcept {
+            return it += n;
         }
 
-        diff_type operator-(const AnotherVectorIter& other) const {
-            return ptr_ - other.ptr_;
+        friend AnotherVectorIter operator+(difference_type n, AnotherVectorIter it) noexcept {
+            return it += n;
         }
 
-        bool operator==(const AnotherVectorIter& other) const {
-            return ptr_ == other.ptr_;
-        }
-        bool operator!=(const AnotherVectorIter& other) const {
-            return ptr_ != other.ptr_;
-        }
-        bool operator<(const AnotherVectorIter& other) const {
-            return ptr_ < other.ptr_;
+        friend AnotherVectorIter operator-(AnotherVectorIter it, difference_type n) noexcept {
+            return it -= n;
         }
-        bool operator>(const AnotherVectorIter& other) const {
-            return ptr_ > other.ptr_;
-        }
-        bool operator<=(const AnotherVectorIter& other) const {
-            return ptr_ <= other.ptr_;
-        }
-        bool operator>=(const AnotherVectorIter& other) const {
-            return ptr_ >= other.ptr_;
+
+        friend difference_type operator-(const AnotherVectorIter& lhs, const AnotherVectorIter& rhs) noexcept {
+            return lhs.ptr_ - rhs.ptr_;
         }
 
+        friend bool operator==(const AnotherVectorIter&, const AnotherVectorIter&) = default;
+        friend auto operator<=>(const AnotherVectorIter&, const AnotherVectorIter&) = default;
+
     private:
         pointer ptr_ = nullptr;
         friend class AnotherVectorIter<true>;
@@ -138,12 +160,18 @@ public:
         reserve(initial_capacity);
     }
 
+    // std::length_error past max_size()
     void reserve(size_t new_capacity) {
+        check_max_size(new_capacity);
         if (new_capacity > capacity_) {
             realloc(new_capacity);
         }
     }
 
+    size_t max_size() const noexcept {
+        return std::allocator_traits<Alloc>::max_size(alloc_);
+    }
+
     void shrink_to_fit() {
         if (capacity_ > size_) {
             realloc(size_);
@@ -158,72 +186,127 @@ public:
         if (is_empty()) {
             return;
         }
-        std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(data_[size_]));
         size_--;
+        std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(data_[size_]));
     }
 
     void pop_front() noexcept {
         if (is_empty()) {
             return;
         }
-        std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(data_[0]));
-        for (size_t i = 0; i < size_; i++) {
-            std::allocator_traits<Alloc>::construct(alloc_, std::addressof(data_[i]),
-                                                    std::move_if_noexcept(data_[i + 1]));
+        for (size_t i = 0; i + 1 < size_; i++) {
+            data_[i] = std::move(data_[i + 1]);
         }
-        size_--;
+        pop_back();
     }
 
     void push_back(const value_type& new_obj) {
-        if (size_ == capacity_) {
-            auto new_cap = get_next_alloc_blob_size();
-            if (new_cap == 0) {
-                new_cap = 1;
+        emplace_back(new_obj);
+    }
+
+    void push_back(value_type&& new_obj) {
+        emplace_back(std::move(new_obj));
+    }
+
+    template <typename... Args>
+    ref emplace_back(Args&&... args) {
+        if (size_ != capacity_) {
+            return construct_back(std::forward<Args>(args)...);
+        }
+        if constexpr (std::is_trivially_copyable_v<V>) {
+            // args may refer to an element: the value is built before the block can move,
+            // then realloc may grow it in place and the value is copied back as bytes
+            V value(std::forward<Args>(args)...);
+            realloc(grow_to(size_ + 1));
+            return construct_back(value);
+        } else {
+            return grow_and_emplace(std::forward<Args>(args)...);
+        }
+    }
+
+    // n elements constructed from the same args (must not refer into this vector),
+    // at most one reallocation
+    template <typename... Args>
+    void emplace_back_n(size_t n, const Args&... args) {
+        reserve_for(n);
+        for (size_t i = 0; i < n; i++) {
+            construct_back(args...);
+        }
+    }
+
+    // Whole range with at most one reallocation when its size is known in advance
+    template <std::ranges::input_range R>
+        requires std::convertible_to<std::ranges::range_reference_t<R>, V>
+    void append_range(R&& range) {
+        if constexpr (std::ranges::forward_range<R> || std::ranges::sized_range<R>) {
+            reserve_for(static_cast<size_t>(std::ranges::distance(range)));
+            for (auto&& item : range) {
+                construct_back(std::forward<decltype(item)>(item));
+            }
+        } else {
+            for (auto&& item : range) {
+                emplace_back(std::forward<decltype(item)>(item));
             }
-            realloc(new_cap);
         }
-        // if alloc has construct method - he s gonna be invoked otherwice placement new
-        std::allocator_traits<Alloc>::construct(alloc_, std::addressof(data_[size_]), new_obj);
-        size_++;
     }
 
-    void push_back(value_type&& new_obj) {
-        if (size_ == capacity_) {
-            auto new_cap = get_next_alloc_blob_size();
-            if (new_cap == 0) {
-                new_cap = 1;
+    // [first, last) must not point into this vector. Returns iterator to the first
+    // inserted element
+    template <std::input_iterator It>
+        requires std::convertible_to<std::iter_reference_t<It>, V>
+    iter insert(citer pos, It first, It last) {
+        const size_t offset = static_cast<size_t>(pos - cbegin());
+        const size_t old_size = size_;
+        append_range(std::ranges::subrange(first, last));
+        // new elements were appended, now rotate them in place
+        std::rotate(begin() + offset, begin() + old_size, end());
+        return begin() + offset;
+    }
+
+    // Grows with default-initialized elements: trivial types are left unset, so the
+    // caller can overwrite them without paying for zeroing
+    void resize_for_overwrite(size_t new_size) {
+        if (new_size <= size_) {
+            while (size_ > new_size) {
+                pop_back();
             }
-            realloc(new_cap);
+            return;
+        }
+        reserve_for(new_size - size_);
+        for (; size_ < new_size; size_++) {
+            ::new (static_cast<void*>(std::addressof(data_[size_]))) V;
         }
-        // if alloc has construct method - he s gonna be invoked otherwice placement new
-        std::allocator_traits<Alloc>::construct(alloc_, std::addressof(data_[size_]),
-                                                std::move(new_obj));
-        size_++;
     }
 
     void realloc(size_t new_cap) {
-        // std::cout << "Realloc with new capacity: " << std::to_string(new_cap) << std::endl;
+        if constexpr (std::is_trivially_copyable_v<V>) {
+            // bytes are the objects: no element-wise moves, in-place growth if alloc can do it
+            if constexpr (requires(Alloc a, ptr p, size_t n) {
+                              { a.reallocate(p, n, n) } -> std::convertible_to<ptr>;
+                          }) {
+                if (ptr grown = alloc_.reallocate(data_, capacity_, new_cap)) {
+                    data_ = grown;
+                    capacity_ = new_cap;
+                    return;
+                }
+            }
+            ptr new_data = std::allocator_traits<allocator_type>::allocate(alloc_, new_cap);
+            if (size_ != 0) {
+                std::memcpy(new_data, data_, size_ * sizeof(V));
+            }
+            release();
+            data_ = new_data;
+            capacity_ = new_cap;
+            return;
+        }
 
         ptr new_data = std::allocator_traits<allocator_type>::allocate(alloc_, new_cap);
-        size_t i = 0;
         try {
-            for (; i < size_; i++) {
-                std::allocator_traits<Alloc>::construct(alloc_, std::addressof(new_data[i]),
-                                                        std::move_if_noexcept(data_[i]));
-            }
+            move_to(new_data, new_cap);
         } catch (...) {
-            for (size_t j = 0; j < i; j++) {
-                std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(new_data[j]));
-            }
+            std::allocator_traits<Alloc>::deallocate(alloc_, new_data, new_cap);
             throw;
         }
-        for (size_t j = 0; j < size_; j++) {
-            std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(data_[j]));
-        }
-        std::allocator_traits<Alloc>::deallocate(alloc_, data_, capacity_);
-
-        data_ = new_data;
-        capacity_ = new_cap;
     }
 
     void clear() noexcept {
@@ -241,6 +324,10 @@ public:
         return capacity_;
     }
 
+    ptr data() noexcept {
+        return data_;
+    }
+
     cptr data() const noexcept {
         return data_;
     }
@@ -254,7 +341,7 @@ public:
     }
 
     ref at(size_t index) {
-        if (index > size_) {
+        if (index >= size_) {
             throw std::out_of_range(
                 std::format("Cannon access {} index of AnotherVector [0:{}]", index, size_));
         }
@@ -263,7 +350,7 @@ public:
     }
 
     cref at(size_t index) const {
-        if (index > size_) {
+        if (index >= size_) {
             throw std::out_of_range(
                 std::format("Cannon access {} index of AnotherVector [0:{}]", index, size_));
         }
@@ -287,12 +374,20 @@ public:
         return citer(data_ + size_);
     }
 
+    citer cbegin() const noexcept {
+        return begin();
+    }
+
+    citer cend() const noexcept {
+        return end();
+    }
+
     ref front() noexcept {
         return data_[0];
     }
 
     ref back() noexcept {
-        return data_[size_];
+        return data_[size_ - 1];
     }
 
     cref front() const noexcept {
@@ -300,12 +395,88 @@ public:
     }
 
     cref back() const noexcept {
-        return data_[size_];
+        return data_[size_ - 1];
     }
 
 private:
-    size_t get_next_alloc_blob_size() const noexcept {
-        return capacity_ * 2;
+    // frees the buffer, elements must be destroyed already
+    void release() noexcept {
+        if (data_) {
+            std::allocator_traits<Alloc>::deallocate(alloc_, data_, capacity_);
+        }
+    }
+
+    void check_max_size(size_t count) const {
+        if (count > max_size()) {
+            throw std::length_error(std::format("AnotherVector can't hold {} elements, max is {}", count, max_size()));
+        }
+    }
+
+    // capacity to hold `required` elements: geometric growth clamped by max_size()
+    size_t grow_to(size_t required) const {
+        check_max_size(required);
+        return std::min(std::max(grow_capacity<Growth>(capacity_), required), max_size());
+    }
+
+    // room for n more elements, geometric growth is kept for repeated calls
+    void reserve_for(size_t n) {
+        if (n > max_size() - size_) {
+            throw std::length_error(std::format("AnotherVector can't hold {} more elements", n));
+        }
+        if (size_ + n > capacity_) {
+            realloc(grow_to(size_ + n));
+        }
+    }
+
+    // moves elements to new_data and frees the old buffer, new_data is left to the caller on throw
+    void move_to(ptr new_data, size_t new_cap) {
+        size_t i = 0;
+        try {
+            for (; i < size_; i++) {
+                std::allocator_traits<Alloc>::construct(alloc_, std::addressof(new_data[i]),
+                                                        std::move_if_noexcept(data_[i]));
+            }
+        } catch (...) {
+            for (size_t j = 0; j < i; j++) {
+                std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(new_data[j]));
+            }
+            throw;
+        }
+        for (size_t j = 0; j < size_; j++) {
+            std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(data_[j]));
+        }
+        release();
+
+        data_ = new_data;
+        capacity_ = new_cap;
+    }
+
+    template <typename... Args>
+    ref grow_and_emplace(Args&&... args) {
+        const size_t new_cap = grow_to(size_ + 1);
+        ptr new_data = std::allocator_traits<Alloc>::allocate(alloc_, new_cap);
+        // new element first: args may refer to an element of this vector
+        try {
+            std::allocator_traits<Alloc>::construct(alloc_, std::addressof(new_data[size_]), std::forward<Args>(args)...);
+        } catch (...) {
+            std::allocator_traits<Alloc>::deallocate(alloc_, new_data, new_cap);
+            throw;
+        }
+        try {
+            move_to(new_data, new_cap);
+        } catch (...) {
+            std::allocator_traits<Alloc>::destroy(alloc_, std::addressof(new_data[size_]));
+            std::allocator_traits<Alloc>::deallocate(alloc_, new_data, new_cap);
+            throw;
+        }
+        return data_[size_++];
+    }
+
+    template <typename... Args>
+    ref construct_back(Args&&... args) {
+        // if alloc has construct method - he s gonna be invoked otherwice placement new
+        std::allocator_traits<Alloc>::construct(alloc_, std::addressof(data_[size_]), std::forward<Args>(args)...);
+        return data_[size_++];
     }
 
     Alloc alloc_{};
@@ -314,10 +485,10 @@ private:
     ptr data_ = nullptr;
 };
 
-template <typename T, typename Alloc>
-struct std::formatter<AnotherVector<T, Alloc>> : std::formatter<std::string> {
+template <typename T, typename Alloc, typename Growth>
+struct std::formatter<AnotherVector<T, Alloc, Growth>> : std::formatter<std::string> {
     template <typename FormatContext>
-    auto format(const AnotherVector<T, Alloc>& vec, FormatContext& ctx) const {
+    auto format(const AnotherVector<T, Alloc, Growth>& vec, FormatContext& ctx) const {
         std::string out = "[";
         for (std::size_t i = 0; i < vec.size(); ++i) {
             out += std::format("{}", vec[i]);
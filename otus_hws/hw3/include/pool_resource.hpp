@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "size_class_pool.hpp"
+
+enum class ResourceKind {
+    MONOTONIC,  // deallocate is a no-op, memory comes back only on release()
+    POOLED,     // freed blocks are reused through size class free lists
+};
+
+// SizeClassPool as std::pmr::memory_resource, so any pmr container can use it
+// without being templated on BetterAlloc. Initial size is a runtime value, the
+// pool is CHAINED and grows when it is full. Requests aligned stricter than the pool
+// get their own operator new block, which release() frees as well. Like
+// std::pmr::unsynchronized_pool_resource it is not thread safe.
+class PoolResource : public std::pmr::memory_resource {
+public:
+    explicit PoolResource(size_t initial_bytes, ResourceKind kind = ResourceKind::POOLED);
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource() override;
+
+    // Frees everything allocated from the resource at once
+    void release() noexcept;
+
+    ResourceKind kind() const noexcept {
+        return kind_;
+    }
+
+    size_t capacity() const noexcept {
+        return pool_.capacity();
+    }
+
+    // over-aligned blocks allocated and not yet deallocated
+    size_t unpooled_blocks() const noexcept {
+        return unpooled_count_;
+    }
+
+private:
+    // Sits in front of an over-aligned block, padded to its alignment
+    struct UnpooledHeader {
+        UnpooledHeader* prev;
+        UnpooledHeader* next;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    ResourceKind kind_;
+    SizeClassPool pool_;
+    UnpooledHeader* unpooled_ = nullptr;
+    size_t unpooled_count_ = 0;
+};
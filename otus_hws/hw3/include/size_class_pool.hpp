@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class PoolGrowth {
+    FIXED,    // single blob, caller falls back to malloc when it is full
+    CHAINED,  // new blob of twice the size is chained when current is full
+};
+
+// Blob split into size classes on demand (CHAINED pool bumps from a chain of
+// geometrically growing blobs instead of giving up when the first one is full). Every class keeps an intrusive
+// free list of returned blocks, so allocate/deallocate are O(1) and freed
+// blocks are reused by the next request of the same class.
+//   classes 0..15  - 16..256 bytes with 16 bytes step
+//   classes 16..   - powers of two from 512 bytes
+class SizeClassPool {
+public:
+    static constexpr size_t ALIGNMENT = 16;
+    static constexpr size_t SMALL_LIMIT = 256;
+    static constexpr size_t SMALL_CLASSES = SMALL_LIMIT / ALIGNMENT;
+    static constexpr size_t CLASSES = SMALL_CLASSES + 55;  // up to 2^63 bytes
+
+    explicit SizeClassPool(size_t capacity, PoolGrowth growth = PoolGrowth::FIXED);
+    ~SizeClassPool();
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    // nullptr if pool has no room for such block (CHAINED: if the next blob can't be allocated)
+    void* allocate(size_t bytes) noexcept;
+    // false if ptr does not belong to the pool
+    bool deallocate(void* ptr, size_t bytes) noexcept;
+    // Plain bump of bytes rounded up to ALIGNMENT, the block can't be recycled.
+    // nullptr under the same conditions as allocate.
+    void* bump(size_t bytes) noexcept;
+    // Puts block to the free list without ownership check. The block may come from
+    // another pool of the same owner as long as that pool outlives this one.
+    void recycle(void* ptr, size_t bytes) noexcept;
+
+    // Forgets every handed out block at once. Chained blobs are released except the
+    // largest one, which is reused from its start. Pointers taken before become invalid.
+    void reset() noexcept;
+
+    bool owns(const void* ptr) const noexcept;
+
+    PoolGrowth growth() const noexcept {
+        return growth_;
+    }
+
+    // bytes in all blobs
+    size_t capacity() const noexcept {
+        return capacity_ + retired_bytes_;
+    }
+
+    // bytes of the current blob never handed out yet
+    size_t untouched() const noexcept {
+        return capacity_ - offset_;
+    }
+
+    static size_t size_class(size_t bytes) noexcept;
+    static size_t class_size(size_t size_class) noexcept;
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    bool grow(size_t min_bytes) noexcept;
+    void* carve(size_t block) noexcept;
+
+    PoolGrowth growth_;
+    // current blob, blocks are bumped from it
+    char* blob_ = nullptr;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    // full blobs of CHAINED pool, still owned until reset
+    std::vector<std::pair<char*, size_t>> retired_;
+    size_t retired_bytes_ = 0;
+    std::array<FreeNode*, CLASSES> free_lists_{};
+};
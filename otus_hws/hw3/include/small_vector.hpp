@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "not_even_vector.hpp"
+
+// Vector that keeps up to K elements inside the object and goes to Alloc only
+// when it outgrows them. shrink_to_fit brings elements back inline once they fit.
+template <typename V, size_t K, AllocatorFor<V> Alloc = std::allocator<V>, GrowthFactor Growth = std::ratio<2>>
+class AnotherSmallVector {
+    static_assert(K > 0, "use AnotherVector if no inline storage is needed");
+
+public:
+    using value_type = V;
+    using allocator_type = Alloc;
+    using ptr = V*;
+    using cptr = const V*;
+    using ref = V&;
+    using cref = const V&;
+    using iter = V*;
+    using citer = const V*;
+
+    static constexpr size_t INLINE_CAPACITY = K;
+
+    AnotherSmallVector() noexcept(std::is_nothrow_default_constructible_v<Alloc>) {
+    }
+
+    explicit AnotherSmallVector(Alloc alloc) noexcept : alloc_(std::move(alloc)) {
+    }
+
+    AnotherSmallVector(const AnotherSmallVector& other)
+        : alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other);
+    }
+
+    AnotherSmallVector(AnotherSmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<V>)
+        : alloc_(other.alloc_) {
+        steal_from(other);
+    }
+
+    AnotherSmallVector& operator=(const AnotherSmallVector& other) {
+        if (this != &other) {
+            clear();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    AnotherSmallVector& operator=(AnotherSmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<V>) {
+        if (this != &other) {
+            clear();
+            release_heap();
+            // memory of other's heap buffer has to be freed by our allocator later
+            alloc_ = other.alloc_;
+            steal_from(other);
+        }
+        return *this;
+    }
+
+    ~AnotherSmallVector() {
+        clear();
+        release_heap();
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity_) {
+            relocate(new_capacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (capacity_ > std::max(size_, K)) {
+            relocate(std::max(size_, K));
+        }
+    }
+
+    bool is_empty() const noexcept {
+        return size_ == 0;
+    }
+
+    bool is_inline() const noexcept {
+        return data_ == inline_data();
+    }
+
+    template <typename... Args>
+    ref emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            return grow_and_emplace(std::forward<Args>(args)...);
+        }
+        std::allocator_traits<Alloc>::construct(alloc_, data_ + size_, std::forward<Args>(args)...);
+        return data_[size_++];
+    }
+
+    void push_back(const value_type& new_obj) {
+        emplace_back(new_obj);
+    }
+
+    void push_back(value_type&& new_obj) {
+        emplace_back(std::move(new_obj));
+    }
+
+    void pop_back() noexcept {
+        if (is_empty()) {
+            return;
+        }
+        size_--;
+        std::allocator_traits<Alloc>::destroy(alloc_, data_ + size_);
+    }
+
+    void clear() noexcept {
+        for (size_t j = 0; j < size_; j++) {
+            std::allocator_traits<Alloc>::destroy(alloc_, data_ + j);
+        }
+        size_ = 0;
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    ptr data() noexcept {
+        return data_;
+    }
+
+    cptr data() const noexcept {
+        return data_;
+    }
+
+    ref operator[](size_t index) noexcept {
+        return data_[index];
+    }
+
+    cref operator[](size_t index) const noexcept {
+        return data_[index];
+    }
+
+    ref at(size_t index) {
+        check_index(index);
+        return data_[index];
+    }
+
+    cref at(size_t index) const {
+        check_index(index);
+        return data_[index];
+    }
+
+    iter begin() noexcept {
+        return data_;
+    }
+
+    iter end() noexcept {
+        return data_ + size_;
+    }
+
+    citer begin() const noexcept {
+        return data_;
+    }
+
+    citer end() const noexcept {
+        return data_ + size_;
+    }
+
+    ref front() noexcept {
+        return data_[0];
+    }
+
+    ref back() noexcept {
+        return data_[size_ - 1];
+    }
+
+    cref front() const noexcept {
+        return data_[0];
+    }
+
+    cref back() const noexcept {
+        return data_[size_ - 1];
+    }
+
+private:
+    ptr inline_data() noexcept {
+        return reinterpret_cast<ptr>(inline_);
+    }
+
+    cptr inline_data() const noexcept {
+        return reinterpret_cast<cptr>(inline_);
+    }
+
+    void check_index(size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range(std::format("Cannon access {} index of AnotherSmallVector [0:{})", index, size_));
+        }
+    }
+
+    void release_heap() noexcept {
+        if (!is_inline()) {
+            std::allocator_traits<Alloc>::deallocate(alloc_, data_, capacity_);
+            data_ = inline_data();
+            capacity_ = K;
+        }
+    }
+
+    // Moves elements [0, size_) to new_data and frees the old buffer. On failure
+    // everything moved so far is destroyed, new_data itself is left to the caller.
+    void move_to(ptr new_data, size_t new_cap) {
+        size_t i = 0;
+        try {
+            for (; i < size_; i++) {
+                std::allocator_traits<Alloc>::construct(alloc_, new_data + i, std::move_if_noexcept(data_[i]));
+            }
+        } catch (...) {
+            for (size_t j = 0; j < i; j++) {
+                std::allocator_traits<Alloc>::destroy(alloc_, new_data + j);
+            }
+            throw;
+        }
+        for (size_t j = 0; j < size_; j++) {
+            std::allocator_traits<Alloc>::destroy(alloc_, data_ + j);
+        }
+        release_heap();
+        data_ = new_data;
+        capacity_ = new_cap;
+    }
+
+    // only called with heap buffer on one side at least: reserve past K or shrink of heap
+    void relocate(size_t new_cap) {
+        ptr new_data = new_cap <= K ? inline_data() : std::allocator_traits<Alloc>::allocate(alloc_, new_cap);
+        try {
+            move_to(new_data, new_cap);
+        } catch (...) {
+            if (new_data != inline_data()) {
+                std::allocator_traits<Alloc>::deallocate(alloc_, new_data, new_cap);
+            }
+            throw;
+        }
+    }
+
+    template <typename... Args>
+    ref grow_and_emplace(Args&&... args) {
+        const size_t new_cap = grow_capacity<Growth>(capacity_);
+        ptr new_data = std::allocator_traits<Alloc>::allocate(alloc_, new_cap);
+        // new element first: args may refer to an element of this vector
+        try {
+            std::allocator_traits<Alloc>::construct(alloc_, new_data + size_, std::forward<Args>(args)...);
+        } catch (...) {
+            std::allocator_traits<Alloc>::deallocate(alloc_, new_data, new_cap);
+            throw;
+        }
+        try {
+            move_to(new_data, new_cap);
+        } catch (...) {
+            std::allocator_traits<Alloc>::destroy(alloc_, new_data + size_);
+            std::allocator_traits<Alloc>::deallocate(alloc_, new_data, new_cap);
+            throw;
+        }
+        return data_[size_++];
+    }
+
+    void copy_from(const AnotherSmallVector& other) {
+        reserve(other.size_);
+        for (const auto& item : other) {
+            std::allocator_traits<Alloc>::construct(alloc_, data_ + size_, item);
+            size_++;
+        }
+    }
+
+    // expects this to be empty and inline
+    void steal_from(AnotherSmallVector& other) noexcept(std::is_nothrow_move_constructible_v<V>) {
+        if (!other.is_inline()) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            other.data_ = other.inline_data();
+            other.capacity_ = K;
+            other.size_ = 0;
+            return;
+        }
+        for (auto& item : other) {
+            std::allocator_traits<Alloc>::construct(alloc_, data_ + size_, std::move(item));
+            size_++;
+        }
+        other.clear();
+    }
+
+    [[no_unique_address]] Alloc alloc_{};
+    size_t size_ = 0;
+    size_t capacity_ = K;
+    alignas(V) std::byte inline_[K * sizeof(V)];
+    ptr data_ = inline_data();
+};
@@ -0,0 +1,241 @@
+#include "concurrent_pool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> next_pool_id{1};
+
+}  // namespace
+
+// Local state of every pool the thread has touched. The last used one is checked
+// first, so a thread working with a single pool does one compare per call.
+template <typename Owner, typename Local>
+class ThreadSlots {
+public:
+    ThreadSlots() = default;
+    ThreadSlots(const ThreadSlots&) = delete;
+    ThreadSlots& operator=(const ThreadSlots&) = delete;
+
+    ~ThreadSlots() {
+        for (auto& slot : slots_) {
+            if (auto owner = slot->owner.lock()) {
+                owner->release(slot->local);
+            }
+        }
+    }
+
+    Local& get(Owner& owner) {
+        if (last_ && last_->id == owner.id_) {
+            return last_->local;
+        }
+        auto it = std::find_if(slots_.begin(), slots_.end(), [&owner](const auto& slot) { return slot->id == owner.id_; });
+        if (it == slots_.end()) {
+            // states of destroyed pools are dropped, their memory is already gone
+            std::erase_if(slots_, [](const auto& slot) { return slot->owner.expired(); });
+            slots_.push_back(std::make_unique<Slot>(Slot{owner.id_, owner.weak_from_this(), Local{}}));
+            it = std::prev(slots_.end());
+        }
+        last_ = it->get();
+        return last_->local;
+    }
+
+private:
+    struct Slot {
+        uint64_t id;
+        std::weak_ptr<Owner> owner;
+        Local local;
+    };
+
+    std::vector<std::unique_ptr<Slot>> slots_;
+    Slot* last_ = nullptr;
+};
+
+ThreadCachePool::ThreadCachePool(size_t capacity) : id_(next_pool_id.fetch_add(1)), capacity_(capacity) {
+    blob_ = static_cast<char*>(std::malloc(capacity));
+    if (!blob_) {
+        throw std::bad_alloc();
+    }
+}
+
+ThreadCachePool::~ThreadCachePool() {
+    std::free(blob_);
+}
+
+ThreadCachePool::ThreadCache* ThreadCachePool::local() noexcept {
+    thread_local ThreadSlots<ThreadCachePool, ThreadCache> slots;
+    try {
+        return &slots.get(*this);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* ThreadCachePool::allocate(size_t bytes) noexcept {
+    const size_t cls = SizeClassPool::size_class(bytes);
+    if (cls >= CLASSES) {
+        return nullptr;
+    }
+    ThreadCache* cache = local();
+    if (!cache || (!cache->heads[cls] && !refill(*cache, cls))) {
+        return nullptr;
+    }
+    FreeNode* node = cache->heads[cls];
+    cache->heads[cls] = node->next;
+    --cache->counts[cls];
+    return node;
+}
+
+bool ThreadCachePool::deallocate(void* ptr, size_t bytes) noexcept {
+    if (!owns(ptr)) {
+        return false;
+    }
+    const size_t cls = SizeClassPool::size_class(bytes);
+    FreeNode* node = ::new (ptr) FreeNode{nullptr, nullptr};
+    ThreadCache* cache = local();
+    if (!cache) {
+        push_batch(cls, node);
+        return true;
+    }
+
+    node->next = cache->heads[cls];
+    cache->heads[cls] = node;
+    if (++cache->counts[cls] >= 2 * BATCH) {
+        // hand a batch back, so threads that only allocate can reuse it
+        FreeNode* tail = node;
+        for (size_t i = 1; i < BATCH; i++) {
+            tail = tail->next;
+        }
+        cache->heads[cls] = tail->next;
+        cache->counts[cls] -= BATCH;
+        tail->next = nullptr;
+        push_batch(cls, node);
+    }
+    return true;
+}
+
+bool ThreadCachePool::refill(ThreadCache& cache, size_t cls) noexcept {
+    {
+        std::lock_guard lock(depot_mutex_);
+        if (FreeNode* batch = depot_[cls]) {
+            depot_[cls] = batch->next_batch;
+            uint32_t count = 0;
+            for (FreeNode* node = batch; node; node = node->next) {
+                ++count;
+            }
+            cache.heads[cls] = batch;
+            cache.counts[cls] = count;
+            return true;
+        }
+    }
+
+    const size_t block = SizeClassPool::class_size(cls);
+    const size_t wanted = std::clamp<size_t>(CARVE_BYTES / block, 1, BATCH);
+    size_t offset = offset_.load(std::memory_order_relaxed);
+    size_t count = 0;
+    do {
+        count = std::min(wanted, (capacity_ - offset) / block);
+        if (count == 0) {
+            return false;
+        }
+    } while (!offset_.compare_exchange_weak(offset, offset + count * block, std::memory_order_relaxed));
+
+    FreeNode* head = nullptr;
+    for (size_t i = count; i-- > 0;) {
+        head = ::new (blob_ + offset + i * block) FreeNode{head, nullptr};
+    }
+    cache.heads[cls] = head;
+    cache.counts[cls] = static_cast<uint32_t>(count);
+    return true;
+}
+
+void ThreadCachePool::push_batch(size_t cls, FreeNode* head) noexcept {
+    std::lock_guard lock(depot_mutex_);
+    head->next_batch = depot_[cls];
+    depot_[cls] = head;
+}
+
+void ThreadCachePool::release(ThreadCache& cache) noexcept {
+    for (size_t cls = 0; cls < CLASSES; cls++) {
+        if (cache.heads[cls]) {
+            push_batch(cls, cache.heads[cls]);
+            cache.heads[cls] = nullptr;
+            cache.counts[cls] = 0;
+        }
+    }
+}
+
+ThreadArenaPool::ThreadArenaPool(size_t initial_capacity)
+    : id_(next_pool_id.fetch_add(1)), initial_capacity_(initial_capacity) {
+}
+
+SizeClassPool* ThreadArenaPool::local() noexcept {
+    thread_local ThreadSlots<ThreadArenaPool, SizeClassPool*> slots;
+    try {
+        SizeClassPool*& arena = slots.get(*this);
+        if (!arena) {
+            std::lock_guard lock(arenas_mutex_);
+            if (!idle_.empty()) {
+                arena = idle_.back();
+                idle_.pop_back();
+            } else {
+                arenas_.reserve(arenas_.size() + 1);
+                arenas_.push_back(std::make_unique<SizeClassPool>(initial_capacity_, PoolGrowth::CHAINED));
+                arena = arenas_.back().get();
+                capacity_.fetch_add(arena->capacity(), std::memory_order_relaxed);
+            }
+        }
+        return arena;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* ThreadArenaPool::allocate(size_t bytes) noexcept {
+    SizeClassPool* arena = local();
+    if (!arena) {
+        return nullptr;
+    }
+    // only this thread touches the arena, other threads read capacity_
+    const size_t before = arena->capacity();
+    void* ptr = arena->allocate(bytes);
+    if (const size_t after = arena->capacity(); after != before) {
+        capacity_.fetch_add(after - before, std::memory_order_relaxed);
+    }
+    return ptr;
+}
+
+bool ThreadArenaPool::deallocate(void* ptr, size_t bytes) noexcept {
+    if (!ptr) {
+        return true;
+    }
+    // all arenas live until the pool is destroyed, so a block of another thread's
+    // arena can be reused here. Without an arena the block is left for the pool.
+    if (SizeClassPool* arena = local()) {
+        arena->recycle(ptr, bytes);
+    }
+    return true;
+}
+
+size_t ThreadArenaPool::capacity() const noexcept {
+    return capacity_.load(std::memory_order_relaxed);
+}
+
+size_t ThreadArenaPool::untouched() noexcept {
+    SizeClassPool* arena = local();
+    return arena ? arena->untouched() : 0;
+}
+
+void ThreadArenaPool::release(SizeClassPool* arena) noexcept {
+    if (!arena) {
+        return;
+    }
+    std::lock_guard lock(arenas_mutex_);
+    try {
+        idle_.push_back(arena);
+    } catch (...) {
+        // arena stays alive, just isn't reused
+    }
+}
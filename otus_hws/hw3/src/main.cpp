@@ -28,6 +28,11 @@ void map_hw_examples_custom() {
     for (const auto& [k, v] : map_with_custom_allocator) {
         std::cout << k << ": " << v << std::endl;
     }
+    if constexpr (ALLOC_STATS_ENABLED) {
+        const auto stats = map_with_custom_allocator.get_allocator().stats();
+        std::cout << std::format("Pool hits: {}, fallback mallocs: {}, high water: {} bytes, fragmentation: {:.2f}\n",
+                                 stats.pool_hits, stats.fallback_mallocs, stats.high_water, stats.fragmentation());
+    }
     std::cout << std::endl;
 }
 
@@ -0,0 +1,63 @@
+#include "pool_resource.hpp"
+
+#include <new>
+
+PoolResource::PoolResource(size_t initial_bytes, ResourceKind kind)
+    : kind_(kind), pool_(initial_bytes, PoolGrowth::CHAINED) {
+}
+
+PoolResource::~PoolResource() {
+    release();
+}
+
+void PoolResource::release() noexcept {
+    while (unpooled_) {
+        UnpooledHeader* header = unpooled_;
+        unpooled_ = header->next;
+        ::operator delete(header, header->alignment + header->bytes, std::align_val_t{header->alignment});
+    }
+    unpooled_count_ = 0;
+    pool_.reset();
+}
+
+void* PoolResource::do_allocate(size_t bytes, size_t alignment) {
+    if (alignment > SizeClassPool::ALIGNMENT) {
+        // blocks are only ALIGNMENT aligned, over-aligned requests bypass the pool;
+        // alignment is at least 32 here, so the header fits into the padding
+        static_assert(sizeof(UnpooledHeader) <= 2 * SizeClassPool::ALIGNMENT);
+        auto* header = static_cast<UnpooledHeader*>(::operator new(alignment + bytes, std::align_val_t{alignment}));
+        *header = {nullptr, unpooled_, bytes, alignment};
+        if (unpooled_) {
+            unpooled_->prev = header;
+        }
+        unpooled_ = header;
+        unpooled_count_++;
+        return reinterpret_cast<std::byte*>(header) + alignment;
+    }
+    void* ptr = kind_ == ResourceKind::MONOTONIC ? pool_.bump(bytes) : pool_.allocate(bytes);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void PoolResource::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+    if (alignment > SizeClassPool::ALIGNMENT) {
+        auto* header = reinterpret_cast<UnpooledHeader*>(static_cast<std::byte*>(ptr) - alignment);
+        (header->prev ? header->prev->next : unpooled_) = header->next;
+        if (header->next) {
+            header->next->prev = header->prev;
+        }
+        unpooled_count_--;
+        ::operator delete(header, alignment + bytes, std::align_val_t{alignment});
+        return;
+    }
+    if (kind_ == ResourceKind::POOLED) {
+        // chained pool never falls back, every block is ours
+        pool_.recycle(ptr, bytes);
+    }
+}
+
+bool PoolResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,123 @@
+#include "size_class_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+SizeClassPool::SizeClassPool(size_t capacity, PoolGrowth growth) : growth_(growth), capacity_(capacity) {
+    // malloc alignment is at least 16 on all supported platforms, class sizes keep it
+    blob_ = static_cast<char*>(std::malloc(capacity));
+    if (!blob_) {
+        throw std::bad_alloc();
+    }
+}
+
+SizeClassPool::~SizeClassPool() {
+    for (auto& [blob, size] : retired_) {
+        std::free(blob);
+    }
+    std::free(blob_);
+}
+
+size_t SizeClassPool::size_class(size_t bytes) noexcept {
+    if (bytes <= SMALL_LIMIT) {
+        return bytes == 0 ? 0 : (bytes - 1) / ALIGNMENT;
+    }
+    // 257..512 -> SMALL_CLASSES, 513..1024 -> SMALL_CLASSES + 1, ...
+    return SMALL_CLASSES + static_cast<size_t>(std::bit_width(bytes - 1)) - 9;
+}
+
+size_t SizeClassPool::class_size(size_t size_class) noexcept {
+    if (size_class < SMALL_CLASSES) {
+        return (size_class + 1) * ALIGNMENT;
+    }
+    return size_t{512} << (size_class - SMALL_CLASSES);
+}
+
+bool SizeClassPool::owns(const void* ptr) const noexcept {
+    const char* p = static_cast<const char*>(ptr);
+    if (p >= blob_ && p < blob_ + capacity_) {
+        return true;
+    }
+    return std::any_of(retired_.begin(), retired_.end(),
+                       [p](const auto& blob) { return p >= blob.first && p < blob.first + blob.second; });
+}
+
+bool SizeClassPool::grow(size_t min_bytes) noexcept {
+    const size_t new_capacity = std::max(capacity_ * 2, min_bytes);
+    char* new_blob = static_cast<char*>(std::malloc(new_capacity));
+    if (!new_blob) {
+        return false;
+    }
+    try {
+        retired_.emplace_back(blob_, capacity_);
+    } catch (...) {
+        std::free(new_blob);
+        return false;
+    }
+    // tail of the old blob is dropped, it is released by reset or destructor
+    retired_bytes_ += capacity_;
+    blob_ = new_blob;
+    capacity_ = new_capacity;
+    offset_ = 0;
+    return true;
+}
+
+void* SizeClassPool::allocate(size_t bytes) noexcept {
+    const size_t cls = size_class(bytes);
+    if (cls >= CLASSES) {
+        return nullptr;
+    }
+
+    if (FreeNode* node = free_lists_[cls]) {
+        free_lists_[cls] = node->next;
+        return node;
+    }
+
+    return carve(class_size(cls));
+}
+
+void* SizeClassPool::bump(size_t bytes) noexcept {
+    if (bytes > std::numeric_limits<size_t>::max() - ALIGNMENT) {
+        return nullptr;
+    }
+    return carve(std::max<size_t>((bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1), ALIGNMENT));
+}
+
+void* SizeClassPool::carve(size_t block) noexcept {
+    if (block > capacity_ - offset_) {
+        if (growth_ == PoolGrowth::FIXED || !grow(block)) {
+            return nullptr;
+        }
+    }
+    void* ptr = blob_ + offset_;
+    offset_ += block;
+    return ptr;
+}
+
+bool SizeClassPool::deallocate(void* ptr, size_t bytes) noexcept {
+    if (!owns(ptr)) {
+        return false;
+    }
+    recycle(ptr, bytes);
+    return true;
+}
+
+void SizeClassPool::recycle(void* ptr, size_t bytes) noexcept {
+    const size_t cls = size_class(bytes);
+    FreeNode* node = ::new (ptr) FreeNode{free_lists_[cls]};
+    free_lists_[cls] = node;
+}
+
+void SizeClassPool::reset() noexcept {
+    // current blob is the largest one, blobs only grow
+    for (auto& [blob, size] : retired_) {
+        std::free(blob);
+    }
+    retired_.clear();
+    retired_bytes_ = 0;
+    offset_ = 0;
+    free_lists_.fill(nullptr);
+}
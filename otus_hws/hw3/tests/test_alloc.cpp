@@ -2,8 +2,23 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <span>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alloc_stats.hpp"
 #include "better_alloc.hpp"
+#include "concurrent_pool.hpp"
 #include "not_even_vector.hpp"
+#include "pool_resource.hpp"
+#include "small_vector.hpp"
+#include "size_class_pool.hpp"
 
 BOOST_AUTO_TEST_SUITE(test_vec)
 
@@ -61,6 +76,109 @@ BOOST_AUTO_TEST_CASE(test_push_back) {
     BOOST_CHECK(v.capacity() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(trivial_realloc) {
+    AnotherVector<int, BetterAlloc<int, 1024>> v;
+    v.push_back(1);
+    const int* first = v.data();
+    v.push_back(2);
+    v.push_back(3);
+    // 4..16 bytes share a size class, growth happens in place
+    BOOST_CHECK(v.data() == first);
+    BOOST_CHECK(v.capacity() == 4);
+
+    for (int i = 4; i <= 1000; i++) {
+        v.push_back(i);
+    }
+    // past the pool, malloc fallback block grows through realloc
+    BOOST_CHECK(v.size() == 1000);
+    BOOST_CHECK(v[0] == 1 && v[999] == 1000);
+}
+
+BOOST_AUTO_TEST_CASE(non_trivial_realloc) {
+    AnotherVector<std::string, BetterAlloc<std::string, 1024>> v;
+    for (int i = 0; i < 100; i++) {
+        v.push_back(std::string(32, static_cast<char>('a' + i % 26)));
+    }
+    BOOST_CHECK(v.size() == 100);
+    BOOST_CHECK(v[27] == std::string(32, 'b'));
+}
+
+BOOST_AUTO_TEST_CASE(bulk_append) {
+    AnotherVector<int> v;
+    std::vector<int> source{1, 2, 3, 4, 5};
+    v.append_range(source);
+    BOOST_CHECK(v.size() == 5 && v.capacity() == 5);
+
+    v.emplace_back_n(3, 7);
+    BOOST_CHECK(v.size() == 8 && v.back() == 7);
+    // growth stays geometric for repeated appends
+    BOOST_CHECK(v.capacity() == 10);
+
+    std::vector<int> middle{10, 11};
+    auto it = v.insert(v.cbegin() + 1, middle.begin(), middle.end());
+    BOOST_CHECK(*it == 10 && it - v.begin() == 1);
+    BOOST_CHECK(v[0] == 1 && v[1] == 10 && v[2] == 11 && v[3] == 2 && v.size() == 10);
+
+    // aliasing push_back through a reallocation
+    v.push_back(v[0]);
+    BOOST_CHECK(v.back() == 1);
+
+    v.resize_for_overwrite(100);
+    BOOST_CHECK(v.size() == 100 && v.capacity() == 100 && v[3] == 2);
+    v.resize_for_overwrite(2);
+    BOOST_CHECK(v.size() == 2 && v.back() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(emplace_aliasing) {
+    // arguments refer into elements moved away by the growth
+    AnotherVector<std::pair<std::string, int>> pairs;
+    pairs.emplace_back(std::string(64, 'a'), 0);
+    pairs.emplace_back(pairs[0].first, 1);
+    pairs.emplace_back(pairs[1].first, pairs[0].second);
+    BOOST_CHECK(pairs.size() == 3 && pairs.capacity() == 4);
+    BOOST_CHECK(pairs[2].first == std::string(64, 'a') && pairs[2].second == 0);
+
+    AnotherVector<std::pair<int, int>, BetterAlloc<std::pair<int, int>, 64>> trivial;
+    trivial.emplace_back(7, 8);
+    for (int i = 0; i < 100; i++) {
+        trivial.emplace_back(trivial.back().second, trivial[0].first);
+    }
+    BOOST_CHECK(trivial.size() == 101 && trivial.back().first == 7 && trivial.back().second == 7);
+}
+
+BOOST_AUTO_TEST_CASE(resize_for_overwrite_growth) {
+    AnotherVector<int> v;
+    size_t reallocations = 0;
+    const int* data = nullptr;
+    for (size_t size = 1; size <= 1000; size++) {
+        v.resize_for_overwrite(size);
+        if (v.data() != data) {
+            data = v.data();
+            reallocations++;
+        }
+    }
+    // geometric growth, not one reallocation per call
+    BOOST_CHECK(v.size() == 1000);
+    BOOST_CHECK(reallocations <= 11);
+}
+
+BOOST_AUTO_TEST_CASE(max_size_and_bounds) {
+    AnotherVector<int> v;
+    BOOST_CHECK_THROW(v.reserve(v.max_size() + 1), std::length_error);
+
+    v.push_back(1);
+    v.push_back(2);
+    BOOST_CHECK(v.back() == 2);
+    BOOST_CHECK_THROW(v.at(2), std::out_of_range);
+
+    AnotherVector<std::string> strings;
+    strings.append_range(std::vector<std::string>{"a", "b", "c"});
+    strings.pop_front();
+    BOOST_CHECK(strings.size() == 2 && strings.front() == "b" && strings.back() == "c");
+    strings.pop_back();
+    BOOST_CHECK(strings.size() == 1 && strings.back() == "b");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(test_iter)
@@ -109,4 +227,402 @@ BOOST_AUTO_TEST_CASE(test_push_back) {
     }
 }
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE(contiguous) {
+    using Vec = AnotherVector<int, BetterAlloc<int, 1024>>;
+    static_assert(std::contiguous_iterator<Vec::iter>);
+    static_assert(std::contiguous_iterator<Vec::citer>);
+    static_assert(std::ranges::contiguous_range<Vec>);
+
+    Vec v;
+    for (int i = 10; i > 0; i--) {
+        v.push_back(i);
+    }
+    BOOST_CHECK(std::to_address(v.begin()) == v.data());
+    BOOST_CHECK(std::to_address(v.end()) == v.data() + v.size());
+
+    std::ranges::sort(v);
+    BOOST_CHECK(std::ranges::is_sorted(v));
+    BOOST_CHECK(std::ranges::find(v, 7) - v.begin() == 6);
+
+    std::span<const int> view(v.begin(), v.end());
+    BOOST_CHECK(view.size() == 10 && view[9] == 10);
+
+    auto it = v.begin() + 3;
+    BOOST_CHECK(*it == 4 && it[2] == 6 && *(2 + it) == 6 && *(it - 1) == 3);
+    it += 2;
+    BOOST_CHECK(it - v.begin() == 5);
+    Vec::citer cit = it;
+    BOOST_CHECK(cit == it && v.cbegin() < cit);
+
+    std::vector<int> copy(10);
+    std::copy(v.cbegin(), v.cend(), copy.begin());
+    BOOST_CHECK(copy.front() == 1 && copy.back() == 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_pool)
+
+BOOST_AUTO_TEST_CASE(size_classes) {
+    BOOST_CHECK(SizeClassPool::class_size(SizeClassPool::size_class(1)) == 16);
+    BOOST_CHECK(SizeClassPool::class_size(SizeClassPool::size_class(40)) == 48);
+    BOOST_CHECK(SizeClassPool::class_size(SizeClassPool::size_class(256)) == 256);
+    BOOST_CHECK(SizeClassPool::class_size(SizeClassPool::size_class(257)) == 512);
+    BOOST_CHECK(SizeClassPool::class_size(SizeClassPool::size_class(4096)) == 4096);
+    BOOST_CHECK(SizeClassPool::class_size(SizeClassPool::size_class(4097)) == 8192);
+}
+
+BOOST_AUTO_TEST_CASE(reuse) {
+    SizeClassPool pool(1024);
+    void* a = pool.allocate(40);
+    void* b = pool.allocate(40);
+    BOOST_CHECK(a && b && a != b);
+    BOOST_CHECK(pool.untouched() == 1024 - 96);
+
+    BOOST_CHECK(pool.deallocate(a, 40));
+    // same class reuses freed block, pool is not touched
+    BOOST_CHECK(pool.allocate(33) == a);
+    BOOST_CHECK(pool.untouched() == 1024 - 96);
+
+    // whole capacity is usable
+    BOOST_CHECK(pool.allocate(512) != nullptr);
+    BOOST_CHECK(pool.allocate(512) == nullptr);
+
+    int outside = 0;
+    BOOST_CHECK(!pool.deallocate(&outside, sizeof(outside)));
+}
+
+BOOST_AUTO_TEST_CASE(map_churn_stays_in_pool) {
+    std::map<int, int, std::less<int>, BetterAlloc<std::pair<const int, int>, 4096>> map;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 20; i++) {
+            map.emplace(i, round);
+        }
+        map.clear();
+    }
+    // nodes are recycled, so only the first 20 ever touch the pool
+    BOOST_CHECK(map.get_allocator().size() >= 4096 - 20 * 64);
+}
+
+BOOST_AUTO_TEST_CASE(chained_growth_and_reset) {
+    SizeClassPool pool(1024, PoolGrowth::CHAINED);
+    void* first = pool.allocate(512);
+    BOOST_CHECK(pool.allocate(512) != nullptr);
+    // next blob is chained instead of giving up
+    void* chained = pool.allocate(512);
+    BOOST_CHECK(chained != nullptr);
+    BOOST_CHECK(pool.capacity() == 1024 + 2048);
+    BOOST_CHECK(pool.owns(first) && pool.owns(chained));
+    // bigger than twice the last blob
+    BOOST_CHECK(pool.allocate(8192) != nullptr);
+    BOOST_CHECK(pool.capacity() == 1024 + 2048 + 8192);
+
+    pool.reset();
+    // only the largest blob survives and is reused from its start
+    BOOST_CHECK(pool.capacity() == 8192);
+    BOOST_CHECK(pool.untouched() == 8192);
+    BOOST_CHECK(!pool.owns(first));
+}
+
+BOOST_AUTO_TEST_CASE(arena_never_falls_back) {
+    ArenaAlloc<int, 256> alloc;
+    {
+        // vector keeps a copy of the allocator, copies share the pool
+        AnotherVector<int, ArenaAlloc<int, 256>> v(0, alloc);
+        for (int i = 0; i < 1000; i++) {
+            v.push_back(i);
+        }
+        BOOST_CHECK(v.size() == 1000);
+        BOOST_CHECK(v[999] == 999);
+        // every regrowth of the vector landed in the pool
+        BOOST_CHECK(alloc.capacity() > 1000 * sizeof(int));
+    }
+    alloc.reset();
+    BOOST_CHECK(alloc.size() == alloc.capacity());
+
+    std::map<int, int, std::less<int>, ArenaAlloc<std::pair<const int, int>, 1024>> map;
+    for (int i = 0; i < 1000; i++) {
+        map.emplace(i, i);
+    }
+    BOOST_CHECK(map.size() == 1000);
+    BOOST_CHECK(map.at(999) == 999);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_threads)
+
+BOOST_AUTO_TEST_CASE(rebind_shares_pool) {
+    std::map<int, int, std::less<int>, BetterAlloc<std::pair<const int, int>, 4096>> map;
+    auto alloc = map.get_allocator();
+    const size_t before = alloc.size();
+    map.emplace(1, 1);
+    // node allocator of the map and the copy handed out are the same pool
+    BOOST_CHECK(alloc.size() < before);
+    BOOST_CHECK(alloc == map.get_allocator());
+    BOOST_CHECK(!(alloc == BetterAlloc<std::pair<const int, int>, 4096>()));
+}
+
+BOOST_AUTO_TEST_CASE(thread_cache_reuse) {
+    auto pool = std::make_shared<ThreadCachePool>(1 << 16);
+    void* a = pool->allocate(40);
+    BOOST_CHECK(pool->owns(a));
+    // one carve takes a whole batch from the blob
+    BOOST_CHECK(pool->untouched() == (1 << 16) - ThreadCachePool::BATCH * 48);
+    BOOST_CHECK(pool->deallocate(a, 40));
+    BOOST_CHECK(pool->allocate(40) == a);
+
+    int outside = 0;
+    BOOST_CHECK(!pool->deallocate(&outside, sizeof(outside)));
+}
+
+template <typename Alloc>
+void hammer(Alloc alloc, size_t threads_count) {
+    // Boost.Test checks aren't thread safe, results are checked after join
+    std::vector<size_t> sizes(threads_count);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threads_count; t++) {
+        threads.emplace_back([alloc, t, &sizes] {
+            std::map<int, int, std::less<int>, Alloc> map(alloc);
+            for (int round = 0; round < 50; round++) {
+                for (int i = 0; i < 100; i++) {
+                    map.emplace(i, static_cast<int>(t));
+                }
+                map.clear();
+            }
+            for (int i = 0; i < 100; i++) {
+                map.emplace(i, static_cast<int>(t));
+            }
+            sizes[t] = map.size();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t size : sizes) {
+        BOOST_CHECK(size == 100);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(shared_alloc_threads) {
+    SharedAlloc<std::pair<const int, int>, 1 << 20> alloc;
+    hammer(alloc, 8);
+    // exited threads gave their cached blocks back, a new thread reuses them
+    const size_t untouched = alloc.size();
+    hammer(alloc, 1);
+    BOOST_CHECK(alloc.size() == untouched);
+}
+
+BOOST_AUTO_TEST_CASE(thread_arena_threads) {
+    ThreadArenaAlloc<std::pair<const int, int>, 1024> alloc;
+    hammer(alloc, 8);
+    const size_t capacity = alloc.capacity();
+    BOOST_CHECK(capacity > 0);
+    // arenas of exited threads are handed to new ones
+    hammer(alloc, 1);
+    BOOST_CHECK(alloc.capacity() == capacity);
+
+    // capacity and stats are read while other threads grow their arenas
+    ThreadArenaAlloc<std::pair<const int, int>, 1024> fresh;
+    std::thread worker([fresh] { hammer(fresh, 4); });
+    size_t seen = 0;
+    for (int i = 0; i < 1000; i++) {
+        seen = std::max(seen, fresh.capacity());
+    }
+    worker.join();
+    BOOST_CHECK(seen <= fresh.capacity());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_pmr)
+
+BOOST_AUTO_TEST_CASE(pooled_containers) {
+    PoolResource resource(1024);
+    std::pmr::map<int, std::pmr::string> map(&resource);
+    for (int i = 0; i < 100; i++) {
+        map.emplace(i, std::pmr::string(64, 'a' + i % 26));
+    }
+    std::pmr::vector<int> v(&resource);
+    for (int i = 0; i < 1000; i++) {
+        v.push_back(i);
+    }
+    BOOST_CHECK(map.at(27).front() == 'b');
+    BOOST_CHECK(v[999] == 999);
+    // runtime size, grown past the initial blob
+    BOOST_CHECK(resource.capacity() > 1024);
+
+    // freed nodes are reused, pool doesn't grow on churn
+    const size_t capacity = resource.capacity();
+    for (int round = 0; round < 10; round++) {
+        map.erase(round);
+        map.emplace(round, std::pmr::string(64, 'z'));
+    }
+    BOOST_CHECK(resource.capacity() == capacity);
+}
+
+BOOST_AUTO_TEST_CASE(monotonic) {
+    PoolResource resource(256, ResourceKind::MONOTONIC);
+    void* a = resource.allocate(24);
+    resource.deallocate(a, 24);
+    // no reuse, plain bump with 16 bytes granularity
+    void* b = resource.allocate(24);
+    BOOST_CHECK(static_cast<char*>(b) - static_cast<char*>(a) == 32);
+
+    // over-aligned requests are served too
+    void* aligned = resource.allocate(100, 64);
+    BOOST_CHECK(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+    resource.deallocate(aligned, 100, 64);
+    BOOST_CHECK(resource.unpooled_blocks() == 0);
+
+    // over-aligned blocks still alive are freed by release() too
+    void* first = resource.allocate(32, 128);
+    void* second = resource.allocate(4096, 4096);
+    BOOST_CHECK(reinterpret_cast<uintptr_t>(first) % 128 == 0);
+    BOOST_CHECK(reinterpret_cast<uintptr_t>(second) % 4096 == 0);
+    std::memset(second, 0xab, 4096);
+    resource.deallocate(first, 32, 128);
+    void* third = resource.allocate(64, 32);
+    BOOST_CHECK(reinterpret_cast<uintptr_t>(third) % 32 == 0);
+    BOOST_CHECK(resource.unpooled_blocks() == 2);
+
+    resource.release();
+    BOOST_CHECK(resource.unpooled_blocks() == 0);
+    BOOST_CHECK(resource.capacity() == 256);
+    BOOST_CHECK(resource.is_equal(resource));
+    BOOST_CHECK(!resource.is_equal(*std::pmr::new_delete_resource()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_stats)
+
+BOOST_AUTO_TEST_CASE(counters) {
+    AllocCounters counters;
+    size_t traced = 0;
+    counters.set_trace([&traced](const AllocEvent&) { ++traced; });
+
+    int a = 0;
+    int b = 0;
+    counters.on_allocate(&a, 48, true);
+    counters.on_allocate(&b, 1000, false);
+    counters.on_deallocate(&b, 1000, false);
+
+    AllocStats stats = counters.snapshot();
+    BOOST_CHECK(stats.pool_hits == 1);
+    BOOST_CHECK(stats.fallback_mallocs == 1);
+    BOOST_CHECK(stats.deallocations == 1);
+    BOOST_CHECK(stats.bytes_in_use == 48);
+    BOOST_CHECK(stats.high_water == 1048);
+    BOOST_CHECK(traced == 3);
+
+    stats.pool_bytes_touched = 64;
+    BOOST_CHECK_CLOSE(stats.fragmentation(), 0.25, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(better_alloc_stats) {
+    std::map<int, int, std::less<int>, BetterAlloc<std::pair<const int, int>, 1024>> map;
+    for (int i = 0; i < 100; i++) {
+        map.emplace(i, i);
+    }
+    const AllocStats stats = map.get_allocator().stats();
+    if constexpr (ALLOC_STATS_ENABLED) {
+        // 1024 bytes hold 21 nodes of 48 bytes, the rest spills to malloc
+        BOOST_CHECK(stats.pool_hits == 21);
+        BOOST_CHECK(stats.fallback_mallocs == 79);
+        BOOST_CHECK(stats.high_water == stats.bytes_in_use);
+        BOOST_CHECK(stats.fragmentation() >= 0.0);
+    } else {
+        BOOST_CHECK(stats.pool_hits == 0);
+    }
+    // disabled counters take no space
+    static_assert(ALLOC_STATS_ENABLED || sizeof(BetterAlloc<int, 1024>) == sizeof(std::shared_ptr<SizeClassPool>));
+}
+
+BOOST_AUTO_TEST_CASE(realloc_counted_once) {
+    BetterAlloc<int, 1024> alloc;
+    AnotherVector<int, BetterAlloc<int, 1024>> v(1, alloc);
+    for (int i = 0; i < 1000; i++) {
+        v.push_back(i);
+    }
+    BOOST_CHECK(v[0] == 0 && v[999] == 999);
+    const AllocStats stats = alloc.stats();
+    if constexpr (ALLOC_STATS_ENABLED) {
+        // one block from the reserve, every growth after it is a single realloc:
+        // in place, to a bigger class, out of the pool to malloc, then std::realloc
+        BOOST_CHECK(stats.pool_hits == 1);
+        BOOST_CHECK(stats.fallback_mallocs == 0);
+        BOOST_CHECK(stats.deallocations == 0);
+        BOOST_CHECK(stats.reallocations == 10);
+        BOOST_CHECK(stats.bytes_in_use == v.capacity() * sizeof(int));
+        BOOST_CHECK(stats.pool_bytes_in_use == 0);
+    } else {
+        BOOST_CHECK(stats.reallocations == 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(test_small_vec)
+
+BOOST_AUTO_TEST_CASE(inline_then_heap) {
+    AnotherSmallVector<std::string, 4> v;
+    BOOST_CHECK(v.capacity() == 4);
+    for (int i = 0; i < 4; i++) {
+        v.push_back(std::to_string(i));
+    }
+    BOOST_CHECK(v.is_inline());
+
+    // argument aliases an element that moves during the growth
+    v.push_back(v[0]);
+    BOOST_CHECK(!v.is_inline());
+    BOOST_CHECK(v.capacity() == 8);
+    BOOST_CHECK(v.back() == "0");
+    BOOST_CHECK(v.at(3) == "3");
+    BOOST_CHECK_THROW(v.at(5), std::out_of_range);
+
+    v.pop_back();
+    v.shrink_to_fit();
+    // fits again, back to inline storage
+    BOOST_CHECK(v.is_inline());
+    BOOST_CHECK(v.size() == 4 && v[3] == "3");
+}
+
+BOOST_AUTO_TEST_CASE(copy_and_move) {
+    AnotherSmallVector<std::string, 2> heap;
+    AnotherSmallVector<std::string, 2> small;
+    for (int i = 0; i < 5; i++) {
+        heap.push_back(std::to_string(i));
+    }
+    small.push_back("a");
+
+    AnotherSmallVector<std::string, 2> copy(heap);
+    BOOST_CHECK(copy.size() == 5 && copy[4] == "4");
+
+    AnotherSmallVector<std::string, 2> moved(std::move(heap));
+    BOOST_CHECK(moved.size() == 5 && heap.is_empty() && heap.is_inline());
+
+    moved = std::move(small);
+    BOOST_CHECK(moved.size() == 1 && moved.is_inline() && moved[0] == "a");
+
+    moved = copy;
+    BOOST_CHECK(moved.size() == 5 && moved[0] == "0");
+}
+
+BOOST_AUTO_TEST_CASE(growth_factor) {
+    AnotherSmallVector<int, 2, std::allocator<int>, std::ratio<3, 2>> v;
+    for (int i = 0; i < 3; i++) {
+        v.push_back(i);
+    }
+    // 2 * 1.5
+    BOOST_CHECK(v.capacity() == 3);
+    v.push_back(3);
+    BOOST_CHECK(v.capacity() == 4);
+
+    AnotherVector<int, std::allocator<int>, std::ratio<3>> wide;
+    wide.push_back(1);
+    wide.push_back(2);
+    BOOST_CHECK(wide.capacity() == 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
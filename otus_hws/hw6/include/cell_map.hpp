@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open addressing hash map from an unsigned integer key to T. Collisions are
+// resolved by linear probing and erase shifts the following entries back, so
+// there are no tombstones and lookups stay short.
+template <typename Key, typename T>
+class PackedHashMap {
+public:
+    using key_type = Key;
+
+    // nullptr if there is no such key
+    const T* find(key_type key) const noexcept {
+        if (size_ == 0) {
+            return nullptr;
+        }
+        const Slot& slot = slots_[locate(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    void insert_or_assign(key_type key, T value) {
+        if ((size_ + 1) * MAX_LOAD_DEN > slots_.size() * MAX_LOAD_NUM) {
+            rehash(std::max(MIN_CAPACITY, slots_.size() * 2));
+        }
+        Slot& slot = slots_[locate(key)];
+        if (!slot.used) {
+            slot.key = key;
+            slot.used = true;
+            size_++;
+        }
+        slot.value = std::move(value);
+    }
+
+    // false if there was no such key
+    bool erase(key_type key) noexcept {
+        if (size_ == 0) {
+            return false;
+        }
+        size_t hole = locate(key);
+        if (!slots_[hole].used) {
+            return false;
+        }
+        // entries after the hole move back unless their home lies in (hole, i]
+        for (size_t i = next(hole); slots_[i].used; i = next(i)) {
+            const size_t ideal = home(slots_[i].key);
+            const bool stays = hole <= i ? (hole < ideal && ideal <= i) : (hole < ideal || ideal <= i);
+            if (!stays) {
+                slots_[hole] = std::move(slots_[i]);
+                hole = i;
+            }
+        }
+        slots_[hole].used = false;
+        size_--;
+        return true;
+    }
+
+    // room for that many entries without rehash
+    void reserve(size_t cells) {
+        const size_t needed = std::bit_ceil(std::max(MIN_CAPACITY, (cells * MAX_LOAD_DEN + MAX_LOAD_NUM - 1) / MAX_LOAD_NUM));
+        if (needed > slots_.size()) {
+            rehash(needed);
+        }
+    }
+
+    void clear() noexcept {
+        slots_.clear();
+        size_ = 0;
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    // f(key, value) for every entry in no particular order
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const Slot& slot : slots_) {
+            if (slot.used) {
+                f(slot.key, slot.value);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        key_type key = 0;
+        T value{};
+        bool used = false;
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16;
+    // kept at most 3/4 full
+    static constexpr size_t MAX_LOAD_NUM = 3;
+    static constexpr size_t MAX_LOAD_DEN = 4;
+
+    // neighbouring cells have neighbouring keys, so bits are mixed before masking
+    size_t home(key_type key) const noexcept {
+        uint64_t bits = static_cast<uint64_t>(key);
+        if constexpr (sizeof(key_type) > sizeof(uint64_t)) {
+            bits ^= static_cast<uint64_t>(key >> 64) * 0x9e3779b97f4a7c15ULL;
+        }
+        bits ^= bits >> 33;
+        bits *= 0xff51afd7ed558ccdULL;
+        bits ^= bits >> 33;
+        return static_cast<size_t>(bits) & (slots_.size() - 1);
+    }
+
+    size_t next(size_t i) const noexcept {
+        return (i + 1) & (slots_.size() - 1);
+    }
+
+    // slot holding key or the empty slot ending its probe sequence, table must not be empty
+    size_t locate(key_type key) const noexcept {
+        size_t i = home(key);
+        while (slots_[i].used && slots_[i].key != key) {
+            i = next(i);
+        }
+        return i;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(slots_);
+        for (Slot& slot : old) {
+            if (slot.used) {
+                size_t i = home(slot.key);
+                while (slots_[i].used) {
+                    i = next(i);
+                }
+                slots_[i] = std::move(slot);
+            }
+        }
+    }
+
+    // size is zero or a power of two
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+// Cells of a matrix: (x, y) packed into one 64-bit key
+template <typename T>
+class CellMap {
+public:
+    using key_type = uint64_t;
+
+    static key_type pack(int x, int y) noexcept {
+        return (static_cast<key_type>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    static int unpack_x(key_type key) noexcept {
+        return static_cast<int>(static_cast<uint32_t>(key >> 32));
+    }
+
+    static int unpack_y(key_type key) noexcept {
+        return static_cast<int>(static_cast<uint32_t>(key));
+    }
+
+    // nullptr if there is no such cell
+    const T* find(int x, int y) const noexcept {
+        return cells_.find(pack(x, y));
+    }
+
+    void insert_or_assign(int x, int y, T value) {
+        cells_.insert_or_assign(pack(x, y), std::move(value));
+    }
+
+    // false if there was no such cell
+    bool erase(int x, int y) noexcept {
+        return cells_.erase(pack(x, y));
+    }
+
+    void reserve(size_t cells) {
+        cells_.reserve(cells);
+    }
+
+    void clear() noexcept {
+        cells_.clear();
+    }
+
+    size_t size() const noexcept {
+        return cells_.size();
+    }
+
+    // f(x, y, value) for every cell in no particular order
+    template <typename F>
+    void for_each(F&& f) const {
+        cells_.for_each([&f](key_type key, const T& value) { f(unpack_x(key), unpack_y(key), value); });
+    }
+
+private:
+    PackedHashMap<key_type, T> cells_;
+};
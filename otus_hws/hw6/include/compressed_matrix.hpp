@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+
+enum class Compression {
+    CSR,  // lines are rows
+    CSC,  // lines are columns
+};
+
+// Immutable sparse matrix stored line by line: cells of line i are
+// indices/values[offsets[i], offsets[i + 1]), sorted by index.
+template <typename T>
+struct CompressedMatrix {
+    Compression layout = Compression::CSR;
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<size_t> offsets{0};
+    std::vector<int> indices;
+    std::vector<T> values;
+
+    size_t lines() const noexcept {
+        return layout == Compression::CSR ? rows : cols;
+    }
+
+    // length of a line
+    size_t line_size() const noexcept {
+        return layout == Compression::CSR ? cols : rows;
+    }
+
+    size_t nnz() const noexcept {
+        return values.size();
+    }
+};
+
+namespace sparse_detail {
+
+// below this many multiply-adds threads cost more than they save
+constexpr size_t PARALLEL_MIN_WORK = 1 << 16;
+
+// Calls kernel(first, last) on ranges of lines with about the same nnz in each, on up
+// to threads threads. 0 picks one per core, but stays serial for small products.
+template <typename T, typename Kernel>
+void for_lines(const CompressedMatrix<T>& matrix, size_t work_per_cell, size_t threads, Kernel kernel) {
+    if (threads == 0) {
+        threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), matrix.nnz() * work_per_cell / PARALLEL_MIN_WORK);
+    }
+    threads = std::min(threads, matrix.lines());
+    if (threads <= 1) {
+        kernel(size_t{0}, matrix.lines());
+        return;
+    }
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+    size_t first = 0;
+    for (size_t part = 1; part <= threads; part++) {
+        size_t last = matrix.lines();
+        if (part < threads) {
+            const size_t target = matrix.nnz() * part / threads;
+            last = static_cast<size_t>(std::lower_bound(matrix.offsets.begin(), matrix.offsets.end(), target) - matrix.offsets.begin());
+            last = std::clamp(last, first, matrix.lines());
+        }
+        if (part < threads) {
+            workers.emplace_back(kernel, first, last);
+        } else {
+            kernel(first, last);
+        }
+        first = last;
+    }
+}
+
+inline const char* layout_name(Compression layout) noexcept {
+    return layout == Compression::CSR ? "CSR" : "CSC";
+}
+
+// out[i] = sum of line i multiplied by x
+template <typename T>
+void line_products(const CompressedMatrix<T>& matrix, std::span<const T> x, std::span<T> out, size_t threads) {
+    const size_t* offsets = matrix.offsets.data();
+    const int* indices = matrix.indices.data();
+    const T* values = matrix.values.data();
+    for_lines(matrix, 1, threads, [=](size_t first, size_t last) {
+        for (size_t line = first; line < last; line++) {
+            T sum{};
+            for (size_t k = offsets[line]; k < offsets[line + 1]; k++) {
+                sum += values[k] * x[indices[k]];
+            }
+            out[line] = sum;
+        }
+    });
+}
+
+// Same for dense b of b_cols columns stored by rows, out is lines x b_cols by rows
+template <typename T>
+void line_products(const CompressedMatrix<T>& matrix, std::span<const T> b, size_t b_cols, std::span<T> out, size_t threads) {
+    const size_t* offsets = matrix.offsets.data();
+    const int* indices = matrix.indices.data();
+    const T* values = matrix.values.data();
+    for_lines(matrix, b_cols, threads, [=](size_t first, size_t last) {
+        for (size_t line = first; line < last; line++) {
+            T* result = out.data() + line * b_cols;
+            std::fill(result, result + b_cols, T{});
+            for (size_t k = offsets[line]; k < offsets[line + 1]; k++) {
+                // contiguous rows on both sides, so this loop is vectorized
+                const T value = values[k];
+                const T* row = b.data() + static_cast<size_t>(indices[k]) * b_cols;
+                for (size_t j = 0; j < b_cols; j++) {
+                    result[j] += value * row[j];
+                }
+            }
+        }
+    });
+}
+
+template <typename T>
+void check_spmv(const char* name, Compression layout, const CompressedMatrix<T>& matrix, size_t x_size, size_t out_size) {
+    if (matrix.layout != layout || x_size != matrix.line_size() || out_size != matrix.lines()) {
+        throw std::invalid_argument(fmt::format("{} needs {} matrix, got {}x{} {} with vector of {} into vector of {}", name,
+                                                layout_name(layout), matrix.rows, matrix.cols, layout_name(matrix.layout), x_size,
+                                                out_size));
+    }
+}
+
+template <typename T>
+void check_spmm(const char* name, Compression layout, const CompressedMatrix<T>& matrix, size_t b_size, size_t b_cols,
+                size_t out_size) {
+    if (matrix.layout != layout || b_size != matrix.line_size() * b_cols || out_size != matrix.lines() * b_cols) {
+        throw std::invalid_argument(fmt::format("{} needs {} matrix, got {}x{} {} with {} values in {} columns into {} values", name,
+                                                layout_name(layout), matrix.rows, matrix.cols, layout_name(matrix.layout), b_size,
+                                                b_cols, out_size));
+    }
+}
+
+}  // namespace sparse_detail
+
+// out = A * x, A has to be CSR: rows are the lines summed in parallel
+template <typename T>
+void spmv(const CompressedMatrix<T>& matrix, std::type_identity_t<std::span<const T>> x, std::type_identity_t<std::span<T>> out, size_t threads = 0) {
+    sparse_detail::check_spmv("spmv", Compression::CSR, matrix, x.size(), out.size());
+    sparse_detail::line_products(matrix, x, out, threads);
+}
+
+// out = transposed A * x, A has to be CSC: its columns are the rows of the transpose
+template <typename T>
+void spmv_transposed(const CompressedMatrix<T>& matrix, std::type_identity_t<std::span<const T>> x,
+                     std::type_identity_t<std::span<T>> out, size_t threads = 0) {
+    sparse_detail::check_spmv("spmv_transposed", Compression::CSC, matrix, x.size(), out.size());
+    sparse_detail::line_products(matrix, x, out, threads);
+}
+
+// out = A * b for dense b of b_cols columns stored by rows, out is rows x b_cols by rows. A has to be CSR
+template <typename T>
+void spmm(const CompressedMatrix<T>& matrix, std::type_identity_t<std::span<const T>> b, size_t b_cols,
+          std::type_identity_t<std::span<T>> out, size_t threads = 0) {
+    sparse_detail::check_spmm("spmm", Compression::CSR, matrix, b.size(), b_cols, out.size());
+    sparse_detail::line_products(matrix, b, b_cols, out, threads);
+}
+
+// out = transposed A * b, out is cols x b_cols by rows. A has to be CSC
+template <typename T>
+void spmm_transposed(const CompressedMatrix<T>& matrix, std::type_identity_t<std::span<const T>> b, size_t b_cols,
+                     std::type_identity_t<std::span<T>> out, size_t threads = 0) {
+    sparse_detail::check_spmm("spmm_transposed", Compression::CSC, matrix, b.size(), b_cols, out.size());
+    sparse_detail::line_products(matrix, b, b_cols, out, threads);
+}
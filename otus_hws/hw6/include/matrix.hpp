@@ -1,16 +1,18 @@
 #pragma once
 
-#include <tuple>
-
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/composite_key.hpp>
-#include <boost/multi_index/tag.hpp>
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
-using namespace boost::multi_index;
+#include "cell_map.hpp"
+#include "compressed_matrix.hpp"
+#include "parallel_sort.hpp"
 
 template <typename T>
 struct Cell {
@@ -20,33 +22,27 @@ struct Cell {
 };
 
 
-struct by_x {};
-struct by_y {};
-struct by_xy {};
-
-template<typename T>
-using Matrix = multi_index_container<
-    Cell<T>,
-    indexed_by<
-        ordered_unique<tag<by_xy>, composite_key<Cell<T>, member<Cell<T>, int, &Cell<T>::x>, member<Cell<T>, int, &Cell<T>::y>>>,
-        ordered_non_unique<tag<by_x>, member<Cell<T>, int, &Cell<T>::x>>,
-        ordered_non_unique<tag<by_y>, member<Cell<T>, int, &Cell<T>::y>>
-    >
->;
-
- 
-class MatrixInterface {
-public:    
-    virtual void insert(int x, int y, int value) = 0;
-    virtual int get_value_at(int x, int y) const = 0;
-    virtual size_t size() const = 0;
-    virtual ~MatrixInterface() {};
-private:
+// Configured by WITH_MATRIX_TRACE cmake option. When off, writes through
+// MatrixProxy don't touch the logger at all.
+#ifdef MATRIX_TRACE
+inline constexpr bool MATRIX_TRACE_ENABLED = true;
+#else
+inline constexpr bool MATRIX_TRACE_ENABLED = false;
+#endif
+
+// What proxies need from a matrix. Proxies keep the concrete type, so every
+// access through matrix[x][y] is inlined instead of going through a vtable.
+template <typename M>
+concept CellStorage = requires(M& matrix, const M& const_matrix, int x, int y, int value) {
+    matrix.insert(x, y, value);
+    { const_matrix.get_value_at(x, y) } -> std::convertible_to<int>;
+    { const_matrix.size() } -> std::convertible_to<size_t>;
 };
 
+template <CellStorage Matrix>
 class CellProxy {
 public:
-    CellProxy(MatrixInterface& matrix, int x, int y)
+    CellProxy(Matrix& matrix, int x, int y)
         : matrix_(matrix), x_(x), y_(y) {}
 
     operator int() const {
@@ -59,117 +55,268 @@ public:
     }
 
 private:
-    MatrixInterface& matrix_;
+    Matrix& matrix_;
     int x_;
     int y_;
 };
 
+template <CellStorage Matrix>
 class RowProxy {
 public:
-    RowProxy(MatrixInterface& matrix, int x)
+    RowProxy(Matrix& matrix, int x)
         : matrix_(matrix), x_(x) {}
 
-    CellProxy operator[](int y) {
-        return CellProxy(matrix_, x_, y);
+    CellProxy<Matrix> operator[](int y) {
+        return CellProxy<Matrix>(matrix_, x_, y);
     }
 
 private:
-    MatrixInterface& matrix_;
+    Matrix& matrix_;
     int x_;
 };
-    
-
 
+// Cells live in a hash map keyed by packed (x, y), so point reads and writes are O(1).
+// Ordered views are sorted copies built on first use after a change; iterators and
+// spans taken from them are invalidated by the next insert. Building a view writes
+// the cache even through const begin/row/column/freeze, so a matrix shared between
+// threads needs a lock around those calls too, not just around writes.
 template<typename T, int default_value>
-class MatrixImpl: public MatrixInterface {
+class MatrixImpl {
 public:
+    // lines freeze() infers from the cells without an explicit shape, 128 MiB of offsets
+    static constexpr size_t FREEZE_MAX_LINES = size_t{1} << 24;
+
     MatrixImpl() {
         spdlog::info("Created matrix with default value {}", default_value);
     }
 
-    void insert(int x, int y, int value) override {
-        auto& index = matrix_.template get<by_xy>();
-        
-        auto it = index.find(std::make_tuple(x, y));
-        
+    void insert(int x, int y, int value) {
         if (value == default_value) {
-            if (it != index.end()) {
-                index.erase(it);
+            if (cells_.erase(x, y)) {
+                invalidate_views();
             }
         } else {
-            if (it != index.end()) {
-                index.modify(it, [value](Cell<T>& cell) {
-                    cell.value = value;
-                });
-            } else {
-                matrix_.emplace(x, y, value);
+            cells_.insert_or_assign(x, y, value);
+            invalidate_views();
+        }
+    }
+
+    // Same result as inserting (x, y, value) items one by one in their order, so the last
+    // write of a cell wins. Items are sorted once on up to threads threads; loaded into
+    // an empty matrix they also become its ordered view without another sort.
+    template <std::ranges::input_range R>
+    void bulk_load(R&& items, size_t threads = 0) {
+        std::vector<Cell<T>> cells;
+        if constexpr (std::ranges::sized_range<R>) {
+            cells.reserve(std::ranges::size(items));
+        }
+        for (const auto& [x, y, value] : items) {
+            cells.push_back(Cell<T>{static_cast<int>(x), static_cast<int>(y), static_cast<T>(value)});
+        }
+        parallel_stable_sort(cells.begin(), cells.end(), xy_less, threads);
+
+        const bool was_empty = cells_.size() == 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < cells.size(); i++) {
+            const Cell<T>& cell = cells[i];
+            if (i + 1 < cells.size() && cells[i + 1].x == cell.x && cells[i + 1].y == cell.y) {
+                continue;
             }
+            if (cell.value == default_value) {
+                if (!was_empty) {
+                    cells_.erase(cell.x, cell.y);
+                }
+                continue;
+            }
+            cells[kept++] = cell;
+        }
+        cells.resize(kept);
+
+        cells_.reserve(cells_.size() + cells.size());
+        for (const Cell<T>& cell : cells) {
+            cells_.insert_or_assign(cell.x, cell.y, cell.value);
+        }
+        invalidate_views();
+        if (was_empty) {
+            by_xy_ = std::move(cells);
+            xy_fresh_ = true;
         }
     }
 
-    int get_value_at(int x, int y) const override {
-        auto& index = matrix_.template get<by_xy>();
-        auto it = index.find(std::make_tuple(x, y));
-        return it == index.end() ? default_value : it->value;
+    int get_value_at(int x, int y) const {
+        const T* value = cells_.find(x, y);
+        return value ? *value : default_value;
     }
 
-    size_t size() const override {
-        return matrix_.size();
+    size_t size() const {
+        return cells_.size();
     }
 
-    using iterator = Matrix<T>::template index<by_xy>::type::iterator;
-    using const_iterator = Matrix<T>::template index<by_xy>::type::const_iterator;
+    // cells of row x ordered by y
+    std::span<const Cell<T>> row(int x) const {
+        const auto& cells = by_xy();
+        auto first = std::lower_bound(cells.begin(), cells.end(), x, [](const Cell<T>& cell, int key) { return cell.x < key; });
+        auto last = std::upper_bound(first, cells.end(), x, [](int key, const Cell<T>& cell) { return key < cell.x; });
+        return {first, last};
+    }
 
-    iterator begin() {
-        return matrix_.template get<by_xy>().begin();
+    // cells of column y ordered by x
+    std::span<const Cell<T>> column(int y) const {
+        const auto& cells = by_yx();
+        auto first = std::lower_bound(cells.begin(), cells.end(), y, [](const Cell<T>& cell, int key) { return cell.y < key; });
+        auto last = std::upper_bound(first, cells.end(), y, [](int key, const Cell<T>& cell) { return key < cell.y; });
+        return {first, last};
     }
 
-    iterator end() {
-        return matrix_.template get<by_xy>().end();
+    // Snapshot for numeric kernels, cells left out are zeros. Shape is at least
+    // rows x cols and grows to fit every cell, negative coordinates can't be stored.
+    // std::length_error if a far away cell would grow the lines past FREEZE_MAX_LINES.
+    CompressedMatrix<T> freeze(Compression layout = Compression::CSR, size_t rows = 0, size_t cols = 0) const
+        requires(default_value == 0)
+    {
+        CompressedMatrix<T> result;
+        result.layout = layout;
+        const bool by_rows = layout == Compression::CSR;
+        const size_t requested_lines = by_rows ? rows : cols;
+        for (const Cell<T>& cell : by_xy()) {
+            if (cell.x < 0 || cell.y < 0) {
+                throw std::out_of_range(fmt::format("Cannot freeze matrix with cell [{}:{}]", cell.x, cell.y));
+            }
+            rows = std::max(rows, static_cast<size_t>(cell.x) + 1);
+            cols = std::max(cols, static_cast<size_t>(cell.y) + 1);
+        }
+        result.rows = rows;
+        result.cols = cols;
+        if (result.lines() > std::max(requested_lines, FREEZE_MAX_LINES)) {
+            throw std::length_error(fmt::format("Freezing {} cells by {} needs {} offsets, pass the shape to freeze explicitly", size(),
+                                                by_rows ? "rows" : "columns", result.lines() + 1));
+        }
+
+        const auto& cells = by_rows ? by_xy() : by_yx();
+        result.offsets.assign(result.lines() + 1, 0);
+        result.indices.reserve(cells.size());
+        result.values.reserve(cells.size());
+        for (const Cell<T>& cell : cells) {
+            result.offsets[static_cast<size_t>(by_rows ? cell.x : cell.y) + 1]++;
+            result.indices.push_back(by_rows ? cell.y : cell.x);
+            result.values.push_back(cell.value);
+        }
+        for (size_t line = 0; line < result.lines(); line++) {
+            result.offsets[line + 1] += result.offsets[line];
+        }
+        return result;
     }
 
+    // cells are read only, changes go through insert
+    using iterator = typename std::vector<Cell<T>>::const_iterator;
+    using const_iterator = typename std::vector<Cell<T>>::const_iterator;
+
     const_iterator begin() const {
-        return matrix_.template get<by_xy>().begin();
+        return by_xy().begin();
     }
 
     const_iterator end() const {
-        return matrix_.template get<by_xy>().end();
+        return by_xy().end();
     }
 
     const_iterator cbegin() const {
-        return matrix_.template get<by_xy>().cbegin();
+        return begin();
     }
 
     const_iterator cend() const {
-        return matrix_.template get<by_xy>().cend();
+        return end();
     }
 
-
 private:
-    Matrix<T> matrix_;
+    static bool xy_less(const Cell<T>& a, const Cell<T>& b) noexcept {
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    }
+
+    void invalidate_views() noexcept {
+        xy_fresh_ = false;
+        yx_fresh_ = false;
+    }
+
+    void collect(std::vector<Cell<T>>& cells) const {
+        cells.clear();
+        cells.reserve(cells_.size());
+        cells_.for_each([&cells](int x, int y, const T& value) { cells.push_back(Cell<T>{x, y, value}); });
+    }
+
+    const std::vector<Cell<T>>& by_xy() const {
+        if (!xy_fresh_) {
+            collect(by_xy_);
+            std::sort(by_xy_.begin(), by_xy_.end(), xy_less);
+            xy_fresh_ = true;
+        }
+        return by_xy_;
+    }
+
+    const std::vector<Cell<T>>& by_yx() const {
+        if (!yx_fresh_) {
+            collect(by_yx_);
+            std::sort(by_yx_.begin(), by_yx_.end(), [](const Cell<T>& a, const Cell<T>& b) {
+                return a.y != b.y ? a.y < b.y : a.x < b.x;
+            });
+            yx_fresh_ = true;
+        }
+        return by_yx_;
+    }
+
+    CellMap<T> cells_;
+    mutable std::vector<Cell<T>> by_xy_;
+    mutable std::vector<Cell<T>> by_yx_;
+    mutable bool xy_fresh_ = true;
+    mutable bool yx_fresh_ = true;
 };
 
 template <typename T, int default_value>
-class MatrixProxy: public MatrixInterface {
+class MatrixProxy {
 public:
     MatrixProxy() {}
 
-    void insert(int x, int y, int value) override {
-        spdlog::info("Trying to add to [{}:{}] value {}", x, y, value);
+    void insert(int x, int y, int value) {
+        if constexpr (MATRIX_TRACE_ENABLED) {
+            spdlog::info("Trying to add to [{}:{}] value {}", x, y, value);
+        }
         matrix_impl_.insert(x, y, value);
     }
 
-    int get_value_at(int x, int y) const override {
+    template <std::ranges::input_range R>
+    void bulk_load(R&& items, size_t threads = 0) {
+        if constexpr (MATRIX_TRACE_ENABLED) {
+            spdlog::info("Loading cells in bulk");
+        }
+        matrix_impl_.bulk_load(std::forward<R>(items), threads);
+    }
+
+    int get_value_at(int x, int y) const {
         return matrix_impl_.get_value_at(x, y);
     }
 
-    RowProxy operator[](int x) {
-        return RowProxy(*this, x);
-    };
+    // deduced: RowProxy can't be named while MatrixProxy is incomplete
+    auto operator[](int x) {
+        return RowProxy<MatrixProxy>(*this, x);
+    }
 
-    size_t size() const override {
+    size_t size() const {
         return matrix_impl_.size();
     }
+
+    std::span<const Cell<T>> row(int x) const {
+        return matrix_impl_.row(x);
+    }
+
+    std::span<const Cell<T>> column(int y) const {
+        return matrix_impl_.column(y);
+    }
+
+    CompressedMatrix<T> freeze(Compression layout = Compression::CSR, size_t rows = 0, size_t cols = 0) const
+        requires(default_value == 0)
+    {
+        return matrix_impl_.freeze(layout, rows, cols);
+    }
+
     using iterator = MatrixImpl<T, default_value>::iterator;
     using const_iterator = MatrixImpl<T, default_value>::const_iterator;
 
@@ -201,10 +348,10 @@ private:
     MatrixImpl<T, default_value> matrix_impl_;
 };
 
-template <>
-struct fmt::formatter<CellProxy> : fmt::formatter<int> {
+template <typename Matrix>
+struct fmt::formatter<CellProxy<Matrix>> : fmt::formatter<int> {
     template <typename FormatContext>
-    auto format(const CellProxy& cell, FormatContext& ctx) const {
+    auto format(const CellProxy<Matrix>& cell, FormatContext& ctx) const {
         return fmt::formatter<int>::format(
             static_cast<int>(cell), ctx
         );
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// below this many elements per thread sorting is left to one thread
+constexpr size_t PARALLEL_SORT_MIN_CHUNK = 1 << 15;
+
+// std::stable_sort on up to threads threads (0 - one per core for big ranges):
+// chunks are sorted in parallel and then merged pairwise, both steps keep the
+// order of equal elements.
+template <std::random_access_iterator It, typename Compare>
+void parallel_stable_sort(It first, It last, Compare comp, size_t threads = 0) {
+    const auto size = static_cast<size_t>(last - first);
+    if (threads == 0) {
+        threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), size / PARALLEL_SORT_MIN_CHUNK);
+    }
+    threads = std::min(threads, size);
+    if (threads <= 1) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+
+    std::vector<It> bounds;
+    for (size_t chunk = 0; chunk <= threads; chunk++) {
+        bounds.push_back(first + static_cast<std::iter_difference_t<It>>(size * chunk / threads));
+    }
+    {
+        std::vector<std::jthread> workers;
+        for (size_t chunk = 0; chunk < threads; chunk++) {
+            workers.emplace_back([=, &bounds] { std::stable_sort(bounds[chunk], bounds[chunk + 1], comp); });
+        }
+    }
+    for (size_t step = 1; step < threads; step *= 2) {
+        std::vector<std::jthread> workers;
+        for (size_t chunk = 0; chunk + step < threads; chunk += 2 * step) {
+            const It middle = bounds[chunk + step];
+            const It end = bounds[std::min(chunk + 2 * step, threads)];
+            workers.emplace_back([=, &bounds] { std::inplace_merge(bounds[chunk], middle, end, comp); });
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cell_map.hpp"
+
+template <typename Tensor>
+class TensorCell {
+public:
+    using value_type = typename std::remove_const_t<Tensor>::value_type;
+    using index_type = typename std::remove_const_t<Tensor>::index_type;
+
+    TensorCell(Tensor& tensor, const index_type& index)
+        : tensor_(tensor), index_(index) {}
+
+    operator value_type() const {
+        return tensor_.get(index_);
+    }
+
+    TensorCell& operator=(const value_type& value)
+        requires(!std::is_const_v<Tensor>)
+    {
+        tensor_.set(index_, value);
+        return *this;
+    }
+
+private:
+    Tensor& tensor_;
+    index_type index_;
+};
+
+// Collects Depth indices of tensor[i][j]..., the last operator[] gives the cell itself
+template <typename Tensor, size_t Depth>
+class TensorProxy {
+public:
+    using index_type = typename std::remove_const_t<Tensor>::index_type;
+
+    TensorProxy(Tensor& tensor, const index_type& index)
+        : tensor_(tensor), index_(index) {}
+
+    auto operator[](int i) const {
+        index_type index = index_;
+        index[Depth] = i;
+        if constexpr (Depth + 1 == std::tuple_size_v<index_type>) {
+            return TensorCell<Tensor>(tensor_, index);
+        } else {
+            return TensorProxy<Tensor, Depth + 1>(tensor_, index);
+        }
+    }
+
+private:
+    Tensor& tensor_;
+    index_type index_;
+};
+
+// Sparse tensor of compile time rank: only cells different from Default are kept.
+// Every coordinate takes 32 bits of a packed key, 64 bits wide up to rank 2 and
+// 128 bits up to rank 4. Cells are read and written as tensor[i][j][k].
+template <typename T, size_t Dims, T Default = T{}>
+class SparseTensor {
+    static_assert(Dims >= 1 && Dims <= 4, "coordinates have to fit a 128 bit key");
+
+    // pedantic builds reject __int128 without the extension marker
+    __extension__ using wide_key = unsigned __int128;
+
+public:
+    using value_type = T;
+    using index_type = std::array<int, Dims>;
+    using key_type = std::conditional_t<Dims <= 2, uint64_t, wide_key>;
+
+    static constexpr size_t RANK = Dims;
+    static constexpr T DEFAULT = Default;
+
+    static key_type pack(const index_type& index) noexcept {
+        key_type key = 0;
+        for (int coordinate : index) {
+            key = (key << 32) | static_cast<uint32_t>(coordinate);
+        }
+        return key;
+    }
+
+    static index_type unpack(key_type key) noexcept {
+        index_type index;
+        for (size_t d = Dims; d-- > 0;) {
+            index[d] = static_cast<int>(static_cast<uint32_t>(key));
+            key >>= 32;
+        }
+        return index;
+    }
+
+    T get(const index_type& index) const {
+        const T* value = cells_.find(pack(index));
+        return value ? *value : Default;
+    }
+
+    // writing Default removes the cell
+    void set(const index_type& index, const T& value) {
+        if (value == Default) {
+            cells_.erase(pack(index));
+        } else {
+            cells_.insert_or_assign(pack(index), value);
+        }
+    }
+
+    auto operator[](int i) {
+        return TensorProxy<SparseTensor, 0>(*this, {})[i];
+    }
+
+    auto operator[](int i) const {
+        return TensorProxy<const SparseTensor, 0>(*this, {})[i];
+    }
+
+    size_t size() const noexcept {
+        return cells_.size();
+    }
+
+    void reserve(size_t cells) {
+        cells_.reserve(cells);
+    }
+
+    void clear() noexcept {
+        cells_.clear();
+    }
+
+    // f(index, value) for every stored cell in no particular order
+    template <typename F>
+    void for_each(F&& f) const {
+        cells_.for_each([&f](key_type key, const T& value) { f(unpack(key), value); });
+    }
+
+    // stored cells ordered by index
+    std::vector<std::pair<index_type, T>> entries() const {
+        std::vector<std::pair<index_type, T>> result;
+        result.reserve(size());
+        for_each([&result](const index_type& index, const T& value) { result.emplace_back(index, value); });
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
+
+private:
+    PackedHashMap<key_type, T> cells_;
+};
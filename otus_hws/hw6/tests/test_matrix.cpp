@@ -2,7 +2,18 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <array>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "matrix.hpp"
+#include "sparse_tensor.hpp"
 
 BOOST_AUTO_TEST_SUITE(test_ips)
 
@@ -36,4 +47,260 @@ BOOST_AUTO_TEST_CASE(ma_repl) {
     BOOST_CHECK(matrix[4][24] == 553);
 }
 
+BOOST_AUTO_TEST_CASE(ma_default_erases) {
+    MatrixProxy<int, -1> matrix;
+    matrix[1][2] = 3;
+    matrix[-5][7] = 4;
+    BOOST_CHECK(matrix.size() == 2);
+    matrix[1][2] = -1;
+    BOOST_CHECK(matrix.size() == 1);
+    BOOST_CHECK(matrix[1][2] == -1);
+    BOOST_CHECK(matrix[-5][7] == 4);
+    matrix[100][100] = -1;
+    BOOST_CHECK(matrix.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ma_random_against_map) {
+    MatrixProxy<int, 0> matrix;
+    std::map<std::pair<int, int>, int> reference;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> coord(-50, 50);
+    std::uniform_int_distribution<int> value(0, 3);
+    for (int i = 0; i < 20000; i++) {
+        const int x = coord(gen);
+        const int y = coord(gen);
+        const int v = value(gen);
+        matrix[x][y] = v;
+        if (v == 0) {
+            reference.erase({x, y});
+        } else {
+            reference[{x, y}] = v;
+        }
+    }
+    BOOST_CHECK(matrix.size() == reference.size());
+
+    std::vector<std::pair<std::pair<int, int>, int>> cells;
+    for (const auto& [x, y, v] : matrix) {
+        cells.push_back({{x, y}, v});
+    }
+    const std::vector<std::pair<std::pair<int, int>, int>> expected(reference.begin(), reference.end());
+    BOOST_CHECK(cells == expected);
+}
+
+BOOST_AUTO_TEST_CASE(ma_views) {
+    MatrixProxy<int, 0> matrix;
+    matrix[2][5] = 1;
+    matrix[1][5] = 2;
+    matrix[2][-3] = 3;
+    matrix[7][0] = 4;
+
+    auto row = matrix.row(2);
+    BOOST_REQUIRE(row.size() == 2);
+    BOOST_CHECK(row[0].y == -3 && row[0].value == 3);
+    BOOST_CHECK(row[1].y == 5 && row[1].value == 1);
+
+    auto column = matrix.column(5);
+    BOOST_REQUIRE(column.size() == 2);
+    BOOST_CHECK(column[0].x == 1 && column[1].x == 2);
+    BOOST_CHECK(matrix.row(3).empty());
+
+    matrix[2][5] = 0;
+    BOOST_CHECK(matrix.row(2).size() == 1);
+    BOOST_CHECK(matrix.column(5).size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ma_freeze) {
+    MatrixProxy<int, 0> matrix;
+    matrix[0][1] = 5;
+    matrix[2][0] = 7;
+    matrix[2][3] = 1;
+
+    auto csr = matrix.freeze();
+    BOOST_CHECK(csr.rows == 3 && csr.cols == 4);
+    BOOST_CHECK((csr.offsets == std::vector<size_t>{0, 1, 1, 3}));
+    BOOST_CHECK((csr.indices == std::vector<int>{1, 0, 3}));
+    BOOST_CHECK((csr.values == std::vector<int>{5, 7, 1}));
+
+    auto csc = matrix.freeze(Compression::CSC, 5, 0);
+    BOOST_CHECK(csc.rows == 5 && csc.cols == 4);
+    BOOST_CHECK((csc.offsets == std::vector<size_t>{0, 1, 2, 2, 3}));
+    BOOST_CHECK((csc.indices == std::vector<int>{2, 0, 2}));
+
+    // far away row would need a huge offsets table, fine when it isn't a line
+    matrix[1 << 25][0] = 2;
+    BOOST_CHECK_THROW(matrix.freeze(), std::length_error);
+    BOOST_CHECK(matrix.freeze(Compression::CSC).rows == (1 << 25) + 1);
+
+    matrix[-1][0] = 1;
+    BOOST_CHECK_THROW(matrix.freeze(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(ma_products) {
+    constexpr int ROWS = 300;
+    constexpr int COLS = 200;
+    constexpr size_t B_COLS = 5;
+    MatrixProxy<int, 0> matrix;
+    std::vector<int> dense(ROWS * COLS, 0);
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> row(0, ROWS - 1);
+    std::uniform_int_distribution<int> col(0, COLS - 1);
+    std::uniform_int_distribution<int> value(-3, 3);
+    for (int i = 0; i < 3000; i++) {
+        const int x = row(gen);
+        const int y = col(gen);
+        const int v = value(gen);
+        matrix[x][y] = v;
+        dense[x * COLS + y] = v;
+    }
+    std::vector<int> b(COLS * B_COLS);
+    for (auto& item : b) {
+        item = value(gen);
+    }
+
+    std::vector<int> expected_spmv(ROWS, 0);
+    std::vector<int> expected_spmm(ROWS * B_COLS, 0);
+    std::vector<int> expected_transposed(COLS, 0);
+    std::vector<int> expected_spmm_transposed(COLS * B_COLS, 0);
+    for (int x = 0; x < ROWS; x++) {
+        for (int y = 0; y < COLS; y++) {
+            expected_spmv[x] += dense[x * COLS + y] * b[y];
+            expected_transposed[y] += dense[x * COLS + y] * b[x % COLS];
+            for (size_t j = 0; j < B_COLS; j++) {
+                expected_spmm_transposed[y * B_COLS + j] += dense[x * COLS + y] * b[(x % COLS) * B_COLS + j];
+            }
+            for (size_t j = 0; j < B_COLS; j++) {
+                expected_spmm[x * B_COLS + j] += dense[x * COLS + y] * b[y * B_COLS + j];
+            }
+        }
+    }
+    std::vector<int> x(b.begin(), b.begin() + COLS);
+    std::vector<int> transposed_x(ROWS);
+    std::vector<int> transposed_b(ROWS * B_COLS);
+    for (int i = 0; i < ROWS; i++) {
+        transposed_x[i] = b[i % COLS];
+        std::copy_n(b.begin() + (i % COLS) * B_COLS, B_COLS, transposed_b.begin() + i * B_COLS);
+    }
+
+    const auto csr = matrix.freeze(Compression::CSR, ROWS, COLS);
+    const auto csc = matrix.freeze(Compression::CSC, ROWS, COLS);
+    for (size_t threads : {1, 3}) {
+        std::vector<int> out(ROWS);
+        spmv(csr, x, out, threads);
+        BOOST_CHECK(out == expected_spmv);
+
+        std::vector<int> transposed(COLS);
+        spmv_transposed(csc, transposed_x, transposed, threads);
+        BOOST_CHECK(transposed == expected_transposed);
+
+        std::vector<int> product(ROWS * B_COLS);
+        spmm(csr, b, B_COLS, product, threads);
+        BOOST_CHECK(product == expected_spmm);
+
+        std::vector<int> transposed_product(COLS * B_COLS);
+        spmm_transposed(csc, transposed_b, B_COLS, transposed_product, threads);
+        BOOST_CHECK(transposed_product == expected_spmm_transposed);
+    }
+
+    std::vector<int> wrong(ROWS + 1);
+    BOOST_CHECK_THROW(spmv(csr, x, wrong), std::invalid_argument);
+    // layout picks the product, CSC never passes for A * x
+    std::vector<int> transposed(COLS);
+    BOOST_CHECK_THROW(spmv(csc, transposed_x, transposed), std::invalid_argument);
+    BOOST_CHECK_THROW(spmv_transposed(csr, x, wrong), std::invalid_argument);
+    std::vector<int> product(ROWS * B_COLS);
+    BOOST_CHECK_THROW(spmm(csc, b, B_COLS, product), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(ma_static_proxies) {
+    static_assert(!std::is_polymorphic_v<MatrixProxy<int, 0>>);
+    static_assert(CellStorage<MatrixImpl<int, 0>>);
+
+    MatrixProxy<int, 3> matrix;
+    auto cell = matrix[1][2];
+    cell = 8;
+    BOOST_CHECK(fmt::format("{} {}", cell, matrix[0][0]) == "8 3");
+    cell = 3;
+    BOOST_CHECK(matrix.size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(te_chained_access) {
+    SparseTensor<int, 3, -1> cube;
+    static_assert(sizeof(SparseTensor<int, 3, -1>::key_type) == 16);
+    BOOST_CHECK(cube[1][2][3] == -1);
+    cube[1][2][3] = 7;
+    cube[-4][0][9] = 2;
+    cube[1][2][4] = 5;
+    BOOST_CHECK(cube.size() == 3);
+    BOOST_CHECK(cube[1][2][3] == 7);
+    BOOST_CHECK(cube[-4][0][9] == 2);
+    BOOST_CHECK(cube[3][2][1] == -1);
+
+    cube[1][2][4] = -1;
+    BOOST_CHECK(cube.size() == 2);
+
+    const auto& view = cube;
+    BOOST_CHECK(view[1][2][3] == 7);
+
+    auto entries = cube.entries();
+    BOOST_REQUIRE(entries.size() == 2);
+    BOOST_CHECK((entries[0].first == std::array<int, 3>{-4, 0, 9}));
+    BOOST_CHECK((entries[1].first == std::array<int, 3>{1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(te_packing) {
+    using Tensor = SparseTensor<double, 4>;
+    constexpr int MIN = std::numeric_limits<int>::min();
+    constexpr int MAX = std::numeric_limits<int>::max();
+    const Tensor::index_type index{MIN, -1, 0, MAX};
+    BOOST_CHECK(Tensor::unpack(Tensor::pack(index)) == index);
+    BOOST_CHECK(Tensor::pack({0, 0, 0, 1}) != Tensor::pack({0, 0, 1, 0}));
+
+    Tensor features;
+    features[MIN][-1][0][MAX] = 0.5;
+    features[0][0][0][0] = 0.0;
+    BOOST_CHECK(features.size() == 1);
+    BOOST_CHECK(features[MIN][-1][0][MAX] == 0.5);
+
+    SparseTensor<int, 1> line;
+    line[5] = 3;
+    BOOST_CHECK(line[5] == 3 && line[4] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(ma_bulk_load) {
+    MatrixProxy<int, 0> matrix;
+    std::vector<std::tuple<int, int, int>> items{{3, 1, 5}, {0, 2, 1}, {3, 1, 6}, {1, 1, 0}, {0, 2, 0}, {2, 2, 4}};
+    matrix.bulk_load(items);
+    BOOST_CHECK(matrix.size() == 2);
+    BOOST_CHECK(matrix[3][1] == 6);
+    BOOST_CHECK(matrix[0][2] == 0);
+    BOOST_CHECK(matrix.row(2).size() == 1);
+
+    std::vector<Cell<int>> more{{2, 2, 0}, {7, 7, 7}};
+    matrix.bulk_load(more);
+    BOOST_CHECK(matrix.size() == 2);
+    BOOST_CHECK(matrix[2][2] == 0 && matrix[7][7] == 7);
+}
+
+BOOST_AUTO_TEST_CASE(ma_bulk_load_matches_inserts) {
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> coord(0, 300);
+    std::uniform_int_distribution<int> value(0, 4);
+    std::vector<Cell<int>> items(100000);
+    for (auto& item : items) {
+        item = {coord(gen), coord(gen), value(gen)};
+    }
+
+    MatrixProxy<int, 0> expected;
+    for (const auto& [x, y, v] : items) {
+        expected[x][y] = v;
+    }
+    MatrixProxy<int, 0> loaded;
+    loaded.bulk_load(items, 3);
+
+    BOOST_CHECK(loaded.size() == expected.size());
+    BOOST_CHECK(std::equal(loaded.begin(), loaded.end(), expected.begin(), expected.end(),
+                           [](const Cell<int>& a, const Cell<int>& b) { return a.x == b.x && a.y == b.y && a.value == b.value; }));
+    BOOST_CHECK(loaded[10][20] == expected[10][20]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()